@@ -0,0 +1,589 @@
+/// @file rex.cpp
+/// @brief Command-line exporter: exports canvases and data objects stored in ROOT files
+///
+/// The objects are selected from the keys of the files (path, glob, class name) before being read,
+/// and exported with ROOTToText (data files) and/or the ExPad backends, in an output tree mirroring the files.
+
+#include "ExportManager.hh"
+#include "GleExportManager.hh"
+#include "GnuplotExportManager.hh"
+#include "Log.hh"
+#include "PlotBuilder.hh"
+#include "PyplotExportManager.hh"
+
+#include "TCanvas.h"
+#include "TClass.h"
+#include "TF1.h"
+#include "TFile.h"
+#include "TGraph.h"
+#include "TGraph2D.h"
+#include "TH1.h"
+#include "THStack.h"
+#include "TKey.h"
+#include "TMultiGraph.h"
+#include "TPRegexp.h"
+#include "TROOT.h"
+#include "TRegexp.h"
+#include "TSystem.h"
+#include "TVirtualPad.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <csignal>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct Options {
+    std::vector<TString> files;
+    std::vector<TString> patterns; // key paths or globs
+    std::vector<TString> classes;  // class names (or base classes)
+    std::vector<TString> formats;  // data, gle, gnuplot, python
+    TString output = ".";
+    TString rttOption = "";
+    int jobs = 1;
+    int processes = -1; // forked workers (-1: threads only)
+    bool verbose = false;
+    bool list = false; // only list the selection
+};
+
+/// @brief Object selected in a file (nothing is read yet)
+struct Item {
+    TString file;
+    TString path;      // path in the file ("dir/name")
+    TString className;
+    bool pad;          // canvas or pad
+};
+
+void PrintUsage() {
+    std::cout << "Usage: rex [options] file.root [file2.root ...]\n"
+              << "Export the canvases and data objects of ROOT files to text files (data) and plotting scripts.\n"
+              << "\n"
+              << "Options:\n"
+              << "  -o, --output DIR    output directory (default: .), the layout of the files is mirrored:\n"
+              << "                      DIR/<file name without .root>/<directories>/<object name>\n"
+              << "  -s, --select PATH   select objects by key path or glob (e.g. 'dir/h_*'), can be repeated;\n"
+              << "                      a pattern without '/' is matched with the object names in all directories\n"
+              << "  -c, --class NAME    select objects inheriting from a class (e.g. TH1), can be repeated\n"
+              << "  -f, --format LIST   comma-separated output formats: data, gle, gnuplot, python (default: data)\n"
+              << "  -O, --rtt-opt OPT   RTT option for the data objects (see ROOTToText::PrintOptions)\n"
+              << "  -j, --jobs N        number of worker threads (0: number of cores, default: 1),\n"
+              << "                      the canvases are read, painted and serialized one at a time\n"
+              << "  -p, --processes N   number of worker processes (0: number of cores), for canvas-heavy exports:\n"
+              << "                      each process reads, paints and exports its objects (replaces -j)\n"
+              << "  -l, --list          list the selected objects without exporting them\n"
+              << "  -v, --verbose       print the files written\n"
+              << "  -h, --help          print this message\n"
+              << std::endl;
+}
+
+/// @brief Parse the command line
+/// @return false if the program should stop (help, or invalid arguments)
+bool ParseArguments(int argc, char** argv, Options& opt, int& status) {
+    status = EXIT_SUCCESS;
+    auto value = [&](int& i) -> const char* {
+        if (i + 1 >= argc) {
+            LOG_ERROR("Missing value for option " << argv[i]);
+            status = 2;
+            return nullptr;
+        }
+        return argv[++i];
+    };
+    for (int i = 1; i < argc; i++) {
+        TString arg(argv[i]);
+        const char* v = nullptr;
+        if (arg == "-h" || arg == "--help") {
+            PrintUsage();
+            return false;
+        }
+        else if (arg == "-v" || arg == "--verbose")
+            opt.verbose = true;
+        else if (arg == "-l" || arg == "--list")
+            opt.list = true;
+        else if (arg == "-o" || arg == "--output") {
+            if (!(v = value(i))) return false;
+            opt.output = v;
+        }
+        else if (arg == "-s" || arg == "--select") {
+            if (!(v = value(i))) return false;
+            opt.patterns.push_back(v);
+        }
+        else if (arg == "-c" || arg == "--class") {
+            if (!(v = value(i))) return false;
+            opt.classes.push_back(v);
+        }
+        else if (arg == "-O" || arg == "--rtt-opt") {
+            if (!(v = value(i))) return false;
+            opt.rttOption = v;
+        }
+        else if (arg == "-f" || arg == "--format") {
+            if (!(v = value(i))) return false;
+            TString list(v);
+            TStringToken token(list, ",");
+            while (token.NextToken())
+                opt.formats.push_back(token);
+        }
+        else if (arg == "-j" || arg == "--jobs" || arg == "-p" || arg == "--processes") {
+            if (!(v = value(i))) return false;
+            TString n(v);
+            if (!n.IsDigit()) {
+                LOG_ERROR("Invalid number of workers: " << v);
+                status = 2;
+                return false;
+            }
+            (arg == "-j" || arg == "--jobs" ? opt.jobs : opt.processes) = n.Atoi();
+        }
+        else if (arg.BeginsWith("-")) {
+            LOG_ERROR("Unknown option " << arg);
+            status = 2;
+            return false;
+        }
+        else
+            opt.files.push_back(arg);
+    }
+    if (opt.files.empty()) {
+        PrintUsage();
+        status = 2;
+        return false;
+    }
+    if (opt.formats.empty()) opt.formats.push_back("data");
+    for (const auto& f : opt.formats) {
+        if (f != "data" && f != "gle" && f != "gnuplot" && f != "python") {
+            LOG_ERROR("Unknown format " << f);
+            status = 2;
+            return false;
+        }
+    }
+    if (opt.jobs <= 0) opt.jobs = std::max(1u, std::thread::hardware_concurrency());
+    if (opt.processes == 0) opt.processes = std::max(1u, std::thread::hardware_concurrency());
+#ifdef _WIN32
+    if (opt.processes > 0) {
+        LOG_WARN("Worker processes are not available on Windows: using " << opt.processes << " threads");
+        opt.jobs = opt.processes;
+        opt.processes = -1;
+    }
+#endif
+    return true;
+}
+
+/// @brief Full match of a string with a glob
+bool MatchGlob(const TString& str, const TString& glob) {
+    TRegexp re(glob, kTRUE);
+    Ssiz_t len = 0;
+    return re.Index(str, &len) == 0 && len == str.Length();
+}
+
+/// @brief Check if a key is selected, from its path and class name only
+bool IsSelected(const Options& opt, const TString& path, const TString& name, TClass* cl) {
+    if (!opt.classes.empty()) {
+        bool found = false;
+        for (const auto& c : opt.classes) {
+            TClass* base = TClass::GetClass(c);
+            if (base && cl->InheritsFrom(base)) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) return false;
+    }
+    if (opt.patterns.empty()) return true;
+    for (const auto& p : opt.patterns) {
+        if (MatchGlob(p.Contains('/') ? path : name, p)) return true;
+    }
+    return false;
+}
+
+/// @brief Classes that can be exported
+bool IsExportable(TClass* cl, bool& pad) {
+    pad = cl->InheritsFrom(TVirtualPad::Class());
+    return pad || cl->InheritsFrom(TH1::Class()) || cl->InheritsFrom(TGraph::Class()) || cl->InheritsFrom(TGraph2D::Class())
+           || cl->InheritsFrom(TF1::Class()) || cl->InheritsFrom(TMultiGraph::Class()) || cl->InheritsFrom(THStack::Class());
+}
+
+/// @brief Select the objects of a directory (and its subdirectories), from the keys only
+void ScanDirectory(const Options& opt, const TString& file, TDirectory* dir, const TString& prefix, std::vector<Item>& items) {
+    std::map<TString, bool> seen; // only the last cycle of each key
+    TIter next(dir->GetListOfKeys());
+    while (TKey* key = static_cast<TKey*>(next())) {
+        TString name = key->GetName();
+        if (seen.count(name)) continue;
+        seen[name] = true;
+        TString path = prefix.IsNull() ? name : prefix + "/" + name;
+        TClass* cl = TClass::GetClass(key->GetClassName());
+        if (!cl) {
+            LOG_WARN("Unknown class " << key->GetClassName() << " for " << file << ":" << path);
+            continue;
+        }
+        if (cl->InheritsFrom(TDirectory::Class())) {
+            TDirectory* sub = dir->GetDirectory(name);
+            if (sub) ScanDirectory(opt, file, sub, path, items);
+            continue;
+        }
+        bool pad = false;
+        if (!IsExportable(cl, pad)) continue;
+        if (IsSelected(opt, path, name, cl))
+            items.push_back({file, path, key->GetClassName(), pad});
+    }
+}
+
+/// @brief Name of the output file (without extension), mirroring the layout of the input files
+TString GetOutputName(const Options& opt, const Item& item) {
+    TString stem = gSystem->BaseName(item.file);
+    if (stem.EndsWith(".root")) stem.Remove(stem.Length() - 5);
+    TString out = opt.output + "/" + stem + "/" + item.path;
+    out.ReplaceAll(" ", "_");
+    if (!gSystem->IsAbsoluteFileName(out) && !out.BeginsWith("./")) out.Prepend("./");
+    return out;
+}
+
+/// @brief Export the selected objects with a pool of workers
+class Exporter {
+public:
+    explicit Exporter(const Options& opt) : opt_(opt), data_(false) {
+        for (const auto& f : opt.formats) {
+            if (f == "data")
+                data_ = true;
+            else if (f == "gle")
+                managers_.emplace_back(new REx::GleExportManager());
+            else if (f == "gnuplot")
+                managers_.emplace_back(new REx::GnuplotExportManager());
+            else if (f == "python")
+                managers_.emplace_back(new REx::PyplotExportManager());
+        }
+        for (auto& m : managers_) {
+            m->SetVerbose(opt.verbose);
+            plotters_.push_back(m.get());
+        }
+        dem_.SetVerbose(opt.verbose);
+    }
+
+    /// @brief Export the objects with worker threads
+    /// @return number of objects that could not be exported
+    int RunThreads(const std::vector<Item>& items) {
+        std::atomic<size_t> next(0);
+        std::atomic<int> nfailed(0);
+        auto work = [&]() {
+            // each worker keeps its own file open (the items are sorted by file)
+            std::unique_ptr<TFile> file;
+            size_t i;
+            while ((i = next++) < items.size()) {
+                std::string error;
+                if (!ExportItem(file, items[i], error)) {
+                    LOG_ERROR(items[i].file << ":" << items[i].path << ": " << error);
+                    nfailed++;
+                }
+            }
+        };
+        int nworkers = std::min<int>(opt_.jobs, items.size());
+        if (nworkers > 1) ROOT::EnableThreadSafety();
+        std::vector<std::thread> workers;
+        for (int w = 1; w < nworkers; w++)
+            workers.emplace_back(work);
+        work();
+        for (auto& t : workers)
+            t.join();
+        return nfailed;
+    }
+
+#ifndef _WIN32
+    /// @brief Export the objects in forked worker processes (ROOT graphics is not thread-safe)
+    ///
+    /// The parent process sends the item indices to the workers, one at a time to balance the load,
+    /// and gets back the status of each item; the output names only depend on the items.
+    /// A worker that dies is not replaced: its current item is reported as failed.
+    /// @return number of objects that could not be exported
+    int RunProcesses(const std::vector<Item>& items) {
+        struct Worker {
+            pid_t pid;
+            int task;   // write end (item indices)
+            int result; // read end (status of the items)
+            long item;  // item in progress (-1: none)
+        };
+        std::vector<Worker> workers;
+        std::vector<std::string> errors(items.size());
+        std::vector<bool> done(items.size(), false);
+        int nprocs = std::min<int>(opt_.processes, items.size());
+
+        std::signal(SIGPIPE, SIG_IGN); // a dead worker is detected on its result pipe
+        std::cout.flush();
+        std::cerr.flush();
+        for (int w = 0; w < nprocs; w++) {
+            int task[2], result[2];
+            if (pipe(task)) {
+                LOG_ERROR("Could not create pipe: " << strerror(errno));
+                break;
+            }
+            if (pipe(result)) {
+                LOG_ERROR("Could not create pipe: " << strerror(errno));
+                close(task[0]);
+                close(task[1]);
+                break;
+            }
+            pid_t pid = fork();
+            if (pid < 0) {
+                LOG_ERROR("Could not start worker process: " << strerror(errno));
+                for (int fd : {task[0], task[1], result[0], result[1]})
+                    close(fd);
+                break;
+            }
+            if (pid == 0) {
+                for (const auto& other : workers) {
+                    close(other.task);
+                    close(other.result);
+                }
+                close(task[1]);
+                close(result[0]);
+                WorkerLoop(items, task[0], result[1]);
+            }
+            close(task[0]);
+            close(result[1]);
+            workers.push_back({pid, task[1], result[0], -1});
+        }
+        if (workers.empty()) return items.size();
+
+        size_t next = 0;
+        auto send = [&](Worker& w) {
+            if (next < items.size()) {
+                uint32_t index = next;
+                if (WriteAll(w.task, &index, sizeof(index))) {
+                    w.item = next++;
+                    return;
+                }
+            }
+            close(w.task); // no more work: the worker exits
+            w.task = -1;
+        };
+        for (auto& w : workers)
+            send(w);
+
+        size_t nrunning = workers.size();
+        std::vector<pollfd> fds(workers.size());
+        while (nrunning > 0) {
+            for (size_t k = 0; k < workers.size(); k++)
+                fds[k] = {workers[k].result, POLLIN, 0}; // negative fd: ignored
+            if (poll(fds.data(), fds.size(), -1) < 0) {
+                if (errno == EINTR) continue;
+                LOG_ERROR("Could not wait for the worker processes: " << strerror(errno));
+                break;
+            }
+            for (size_t k = 0; k < workers.size(); k++) {
+                auto& w = workers[k];
+                if (w.result < 0 || !fds[k].revents) continue;
+                uint32_t index = 0, len = 0;
+                uint8_t ok = 0;
+                std::string error;
+                bool read = ReadAll(w.result, &index, sizeof(index)) && ReadAll(w.result, &ok, sizeof(ok))
+                            && ReadAll(w.result, &len, sizeof(len)) && index < items.size();
+                if (read) {
+                    error.resize(len);
+                    read = ReadAll(w.result, &error[0], len);
+                }
+                if (read) {
+                    done[index] = true;
+                    if (!ok) errors[index] = error.empty() ? "export failed" : error;
+                    w.item = -1;
+                    send(w);
+                    continue;
+                }
+                // end of the worker: no more work, or crash
+                int status = 0;
+                waitpid(w.pid, &status, 0);
+                if (w.item >= 0) {
+                    done[w.item] = true;
+                    errors[w.item] = WIFSIGNALED(status) ? "worker killed by signal " + std::to_string(WTERMSIG(status))
+                                                         : "worker exited with status " + std::to_string(WEXITSTATUS(status));
+                }
+                close(w.result);
+                w.result = -1;
+                if (w.task >= 0) {
+                    close(w.task);
+                    w.task = -1;
+                }
+                nrunning--;
+            }
+        }
+
+        // the errors are reported in the order of the items (deterministic output)
+        int nfailed = 0;
+        for (size_t i = 0; i < items.size(); i++) {
+            if (!done[i]) errors[i] = "not exported (no worker left)";
+            if (errors[i].empty()) continue;
+            LOG_ERROR(items[i].file << ":" << items[i].path << ": " << errors[i]);
+            nfailed++;
+        }
+        return nfailed;
+    }
+#endif
+
+private:
+    /// @brief Export an item, reading it from the file of the previous item if possible
+    bool ExportItem(std::unique_ptr<TFile>& file, const Item& item, std::string& error) {
+        if (!file || item.file != file->GetName()) {
+            file.reset(TFile::Open(item.file, "READ"));
+            if (!file || file->IsZombie()) {
+                file.reset();
+                error = "could not open file";
+                return false;
+            }
+        }
+        return Export(*file, item, error);
+    }
+
+    bool Export(TFile& file, const Item& item, std::string& error) {
+        TString out = GetOutputName(opt_, item);
+        gSystem->mkdir(gSystem->DirName(out), true);
+        bool ok = true;
+        try {
+            if (item.pad) {
+                // ROOT graphics is not thread-safe: one canvas at a time (no contention in a worker process)
+                std::lock_guard<std::mutex> lock(graphics_);
+                std::unique_ptr<TVirtualPad> pad(dynamic_cast<TVirtualPad*>(file.Get(item.path)));
+                if (!pad) {
+                    error = "could not read object";
+                    return false;
+                }
+                // the axis ranges are set when the pad is painted
+                if (auto canvas = dynamic_cast<TCanvas*>(pad.get())) {
+                    canvas->Draw();
+                    canvas->Update();
+                }
+                if (data_) ok = REx::BaseExportManager::ExportPad(pad.get(), out, {&dem_}) && ok;
+                if (!plotters_.empty()) ok = REx::BaseExportManager::ExportPad(pad.get(), out, plotters_) && ok;
+            }
+            else {
+                std::unique_ptr<TObject> obj(file.Get(item.path));
+                if (!obj) {
+                    error = "could not read object";
+                    return false;
+                }
+                if (auto h = dynamic_cast<TH1*>(obj.get())) h->SetDirectory(nullptr);
+                if (data_) ok = dem_.SaveObject(obj.get(), out, opt_.rttOption) && ok;
+                if (!plotters_.empty()) {
+                    // the data objects are not drawn: no graphics, no lock
+                    REx::PlotBuilder plot(obj->GetName());
+                    plot.Add(obj.get(), obj->InheritsFrom(TGraph::Class()) || obj->InheritsFrom(TMultiGraph::Class()) ? "AP" : "");
+                    ok = REx::BaseExportManager::ExportPlot(plot, out, plotters_) && ok;
+                }
+            }
+        } catch (const std::exception& e) {
+            error = e.what();
+            return false;
+        }
+        if (!ok)
+            error = "some files could not be written";
+        else if (opt_.verbose)
+            LOG_INFO("Exported " << item.file << ":" << item.path << " --> " << out);
+        return ok;
+    }
+
+#ifndef _WIN32
+    /// @brief Worker process: export the items received on the task pipe, until it is closed
+    [[noreturn]] void WorkerLoop(const std::vector<Item>& items, int task, int result) {
+        std::unique_ptr<TFile> file;
+        uint32_t index;
+        while (ReadAll(task, &index, sizeof(index)) && index < items.size()) {
+            std::string error;
+            uint8_t ok = ExportItem(file, items[index], error);
+            uint32_t len = error.size();
+            std::cout.flush();
+            if (!WriteAll(result, &index, sizeof(index)) || !WriteAll(result, &ok, sizeof(ok))
+                || !WriteAll(result, &len, sizeof(len)) || !WriteAll(result, error.data(), len))
+                break;
+        }
+        file.reset();
+        std::cout.flush();
+        std::cerr.flush();
+        _exit(0); // the exit handlers belong to the parent process
+    }
+
+    static bool ReadAll(int fd, void* buf, size_t size) {
+        char* p = static_cast<char*>(buf);
+        while (size > 0) {
+            ssize_t n = read(fd, p, size);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    static bool WriteAll(int fd, const void* buf, size_t size) {
+        const char* p = static_cast<const char*>(buf);
+        while (size > 0) {
+            ssize_t n = write(fd, p, size);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+#endif
+
+private:
+    const Options& opt_;
+    bool data_; // export the data files
+    REx::DataExportManager dem_;
+    std::vector<std::unique_ptr<REx::BaseExportManager>> managers_;
+    std::vector<const REx::BaseExportManager*> plotters_;
+    std::mutex graphics_;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    int status;
+    if (!ParseArguments(argc, argv, opt, status)) return status;
+
+    gROOT->SetBatch(true);
+    // no background logging thread in the worker processes
+    REx::Logger::GetInstance()->SetAsync(opt.processes < 0 && opt.jobs > 1);
+
+    // selection from the keys only: the objects are read by the workers
+    std::vector<Item> items;
+    int nfailed = 0;
+    for (const auto& filename : opt.files) {
+        std::unique_ptr<TFile> file(TFile::Open(filename, "READ"));
+        if (!file || file->IsZombie()) {
+            LOG_ERROR("Could not open file " << filename);
+            nfailed++;
+            continue;
+        }
+        ScanDirectory(opt, filename, file.get(), "", items);
+    }
+
+    if (opt.list) {
+        for (const auto& item : items)
+            std::cout << item.file << ":" << item.path << " (" << item.className << ")" << std::endl;
+        return nfailed ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    Exporter exporter(opt);
+#ifndef _WIN32
+    int nerrors = opt.processes > 0 ? exporter.RunProcesses(items) : exporter.RunThreads(items);
+#else
+    int nerrors = exporter.RunThreads(items);
+#endif
+
+    REx::Logger::GetInstance()->Flush();
+    std::cout << items.size() - nerrors << "/" << items.size() << " objects exported" << std::endl;
+    return nfailed || nerrors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,217 @@
+#include "DataScan.hh"
+
+#include <cmath>
+#include <limits>
+
+// Vectorized kernels:
+// - AVX2 on x86 (selected at run time with gcc/clang, at compile time with MSVC /arch:AVX2)
+// - NEON on 64-bit ARM
+// - scalar fallback otherwise
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define REX_SCAN_AVX2
+#define REX_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(__AVX2__)
+#define REX_SCAN_AVX2
+#define REX_TARGET_AVX2
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define REX_SCAN_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+const double kInf = std::numeric_limits<double>::infinity();
+
+/// @brief Update the summary with a single value
+inline void ScanValue(double v, REx::DataSummary& s) {
+    if (v != 0) s.allZero = false;
+    if (std::isnan(v)) {
+        s.hasNaN = true;
+        return;
+    }
+    if (std::isinf(v)) {
+        s.hasInf = true;
+        return;
+    }
+    if (v < s.min) s.min = v;
+    if (v > s.max) s.max = v;
+    if (v > 0 && v < s.minPositive) s.minPositive = v;
+    if (std::floor(v) != v) s.integer = false;
+}
+
+/// @brief Update the monotonicity flags with two consecutive values
+inline void ScanPair(double a, double b, REx::DataSummary& s) {
+    if (!(a <= b)) s.increasing = false;
+    if (!(a >= b)) s.decreasing = false;
+}
+
+/// @brief Scalar scan of x[begin..n[ (also used for the remainder of the vectorized loops)
+void ScanTail(const double* x, int begin, int n, REx::DataSummary& s) {
+    for (int i = begin; i < n; i++) {
+        ScanValue(x[i], s);
+        if (i + 1 < n) ScanPair(x[i], x[i + 1], s);
+    }
+}
+
+REx::DataSummary ScanScalar(const double* x, int n) {
+    REx::DataSummary s;
+    s.n = n;
+    ScanTail(x, 0, n, s);
+    return s;
+}
+
+#ifdef REX_SCAN_AVX2
+REX_TARGET_AVX2 REx::DataSummary ScanAVX2(const double* x, int n) {
+    REx::DataSummary s;
+    s.n = n;
+    const __m256d inf = _mm256_set1_pd(kInf);
+    const __m256d ninf = _mm256_set1_pd(-kInf);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d absmask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+    __m256d vmin = inf;
+    __m256d vmax = ninf;
+    __m256d vminp = inf;
+    // flags are accumulated as bit masks
+    __m256d nonzero = zero;
+    __m256d nan = zero;
+    __m256d isinf = zero;
+    __m256d nonint = zero;
+    __m256d notinc = zero;
+    __m256d notdec = zero;
+    int i = 0;
+    for (; i + 4 < n; i += 4) {
+        __m256d a = _mm256_loadu_pd(x + i);
+        __m256d b = _mm256_loadu_pd(x + i + 1); // next values (monotonicity)
+        __m256d absa = _mm256_and_pd(a, absmask);
+        __m256d finite = _mm256_cmp_pd(absa, inf, _CMP_LT_OQ); // false for NaN and inf
+        nonzero = _mm256_or_pd(nonzero, _mm256_cmp_pd(a, zero, _CMP_NEQ_UQ));
+        nan = _mm256_or_pd(nan, _mm256_cmp_pd(a, a, _CMP_UNORD_Q));
+        isinf = _mm256_or_pd(isinf, _mm256_cmp_pd(absa, inf, _CMP_EQ_OQ));
+        vmin = _mm256_min_pd(vmin, _mm256_blendv_pd(inf, a, finite));
+        vmax = _mm256_max_pd(vmax, _mm256_blendv_pd(ninf, a, finite));
+        __m256d pos = _mm256_and_pd(finite, _mm256_cmp_pd(a, zero, _CMP_GT_OQ));
+        vminp = _mm256_min_pd(vminp, _mm256_blendv_pd(inf, a, pos));
+        __m256d fl = _mm256_round_pd(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+        nonint = _mm256_or_pd(nonint, _mm256_and_pd(finite, _mm256_cmp_pd(fl, a, _CMP_NEQ_UQ)));
+        notinc = _mm256_or_pd(notinc, _mm256_cmp_pd(a, b, _CMP_NLE_UQ));
+        notdec = _mm256_or_pd(notdec, _mm256_cmp_pd(a, b, _CMP_NGE_UQ));
+    }
+    // horizontal reduction
+    double lmin[4], lmax[4], lminp[4];
+    _mm256_storeu_pd(lmin, vmin);
+    _mm256_storeu_pd(lmax, vmax);
+    _mm256_storeu_pd(lminp, vminp);
+    for (int k = 0; k < 4; k++) {
+        if (lmin[k] < s.min) s.min = lmin[k];
+        if (lmax[k] > s.max) s.max = lmax[k];
+        if (lminp[k] < s.minPositive) s.minPositive = lminp[k];
+    }
+    s.allZero = !_mm256_movemask_pd(nonzero);
+    s.hasNaN = _mm256_movemask_pd(nan) != 0;
+    s.hasInf = _mm256_movemask_pd(isinf) != 0;
+    s.integer = !_mm256_movemask_pd(nonint);
+    s.increasing = !_mm256_movemask_pd(notinc);
+    s.decreasing = !_mm256_movemask_pd(notdec);
+    ScanTail(x, i, n, s);
+    return s;
+}
+#endif
+
+#ifdef REX_SCAN_NEON
+REx::DataSummary ScanNEON(const double* x, int n) {
+    REx::DataSummary s;
+    s.n = n;
+    const float64x2_t inf = vdupq_n_f64(kInf);
+    const float64x2_t ninf = vdupq_n_f64(-kInf);
+    const float64x2_t zero = vdupq_n_f64(0.);
+    float64x2_t vmin = inf;
+    float64x2_t vmax = ninf;
+    float64x2_t vminp = inf;
+    // flags are accumulated as bit masks (set when the property is violated)
+    uint64x2_t nonzero = vdupq_n_u64(0);
+    uint64x2_t nan = vdupq_n_u64(0);
+    uint64x2_t isinf = vdupq_n_u64(0);
+    uint64x2_t nonint = vdupq_n_u64(0);
+    uint64x2_t notinc = vdupq_n_u64(0);
+    uint64x2_t notdec = vdupq_n_u64(0);
+    const uint64x2_t ones = vdupq_n_u64(~0ULL);
+    int i = 0;
+    for (; i + 2 < n; i += 2) {
+        float64x2_t a = vld1q_f64(x + i);
+        float64x2_t b = vld1q_f64(x + i + 1); // next values (monotonicity)
+        float64x2_t absa = vabsq_f64(a);
+        uint64x2_t finite = vcltq_f64(absa, inf); // false for NaN and inf
+        nonzero = vorrq_u64(nonzero, veorq_u64(vceqq_f64(a, zero), ones));
+        nan = vorrq_u64(nan, veorq_u64(vceqq_f64(a, a), ones));
+        isinf = vorrq_u64(isinf, vceqq_f64(absa, inf));
+        vmin = vminq_f64(vmin, vbslq_f64(finite, a, inf));
+        vmax = vmaxq_f64(vmax, vbslq_f64(finite, a, ninf));
+        uint64x2_t pos = vandq_u64(finite, vcgtq_f64(a, zero));
+        vminp = vminq_f64(vminp, vbslq_f64(pos, a, inf));
+        nonint = vorrq_u64(nonint, vandq_u64(finite, veorq_u64(vceqq_f64(vrndmq_f64(a), a), ones)));
+        notinc = vorrq_u64(notinc, veorq_u64(vcleq_f64(a, b), ones));
+        notdec = vorrq_u64(notdec, veorq_u64(vcgeq_f64(a, b), ones));
+    }
+    s.min = vminvq_f64(vmin);
+    s.max = vmaxvq_f64(vmax);
+    s.minPositive = vminvq_f64(vminp);
+    s.allZero = !vmaxvq_u32(vreinterpretq_u32_u64(nonzero));
+    s.hasNaN = vmaxvq_u32(vreinterpretq_u32_u64(nan)) != 0;
+    s.hasInf = vmaxvq_u32(vreinterpretq_u32_u64(isinf)) != 0;
+    s.integer = !vmaxvq_u32(vreinterpretq_u32_u64(nonint));
+    s.increasing = !vmaxvq_u32(vreinterpretq_u32_u64(notinc));
+    s.decreasing = !vmaxvq_u32(vreinterpretq_u32_u64(notdec));
+    ScanTail(x, i, n, s);
+    return s;
+}
+#endif
+
+typedef REx::DataSummary (*scan_kernel)(const double*, int);
+
+/// @brief Select the fastest kernel available on this machine
+scan_kernel SelectKernel(const char*& name) {
+#if defined(REX_SCAN_AVX2) && defined(_MSC_VER)
+    name = "avx2";
+    return ScanAVX2;
+#elif defined(REX_SCAN_AVX2)
+    if (__builtin_cpu_supports("avx2")) {
+        name = "avx2";
+        return ScanAVX2;
+    }
+#elif defined(REX_SCAN_NEON)
+    name = "neon";
+    return ScanNEON;
+#endif
+    name = "scalar";
+    return ScanScalar;
+}
+
+const char* kernel_name = nullptr;
+const scan_kernel kernel = SelectKernel(kernel_name);
+
+} // namespace
+
+namespace REx {
+
+DataSummary::DataSummary() {
+    min = kInf;
+    max = -kInf;
+    minPositive = kInf;
+}
+
+/// @brief Compute the properties of a column of data (min/max, monotonicity, NaN/inf, etc...) in a single pass
+/// @param x data
+/// @param n number of values
+DataSummary ScanData(const double* x, int n) {
+    if (!x || n <= 0) return DataSummary();
+    return kernel(x, n);
+}
+
+/// @brief Name of the kernel used by ScanData on this machine (avx2, neon or scalar)
+const char* GetScanKernelName() {
+    return kernel_name;
+}
+
+} // namespace REx
@@ -0,0 +1,31 @@
+#ifndef DATASCAN_HH
+#define DATASCAN_HH
+
+namespace REx {
+
+/// @brief Properties of a column of data, computed in a single pass by ScanData
+///
+/// min, max and minPositive only consider finite values:
+/// if the column has no (positive) finite value, min > max (minPositive > max).
+struct DataSummary {
+    int n = 0;                  // number of values
+    double min;                 // smallest finite value
+    double max;                 // largest finite value
+    double minPositive;         // smallest finite value > 0 (useful for log axes)
+    bool allZero = true;        // all values are exactly 0
+    bool increasing = true;     // x[i] <= x[i+1] for all i
+    bool decreasing = true;     // x[i] >= x[i+1] for all i
+    bool hasNaN = false;        // at least one NaN
+    bool hasInf = false;        // at least one infinite value
+    bool integer = true;        // all finite values are integers
+    DataSummary();
+    inline bool HasFinite() const { return min <= max; }
+};
+
+DataSummary ScanData(const double* x, int n);
+
+const char* GetScanKernelName();
+
+} // namespace REx
+
+#endif
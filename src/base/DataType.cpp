@@ -1,57 +1,95 @@
 #include "DataType.hh"
 
+#include "TClass.h"
 #include "TObject.h"
 
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 namespace REx {
 
-DataType GetDataType(const TObject* obj) {
-    // histogram
-    if (obj->InheritsFrom("TH1")) {
-        if (obj->InheritsFrom("TH3")) {
-            return Histo3D;
-        }
-        if (obj->InheritsFrom("TH2")) {
-            return Histo2D;
-        }
-        return Histo1D;
-    }
-    else if (obj->InheritsFrom("TGraph")) {
-        return Graph1D;
-    }
-    else if (obj->InheritsFrom("TGraph2D")) {
-        return Graph2D;
-    }
-    else if (obj->InheritsFrom("TMultiGraph")) {
-        return MultiGraph1D;
-    }
-    else if (obj->InheritsFrom("THStack")) {
-        return MultiHisto1D;
-    }
-    else if (obj->InheritsFrom("TF1")) {
-        if (obj->InheritsFrom("TF2")) {
-            return Function2D;
+namespace {
+
+/// @brief Class (and its derived classes) associated with a data type
+struct TypeRule {
+    const char* name;
+    DataType type;
+    TClass* cl; // resolved when first needed (the library of the class may not be loaded yet)
+};
+
+/// @brief Rules of GetDataType, the derived classes first, and cache of the classes already resolved
+///
+/// The cache is filled by GetDataType (possibly from the export threads), so it is guarded by a mutex.
+struct TypeRegistry {
+    std::vector<TypeRule> user; // registered by RegisterDataType, the last one first
+    std::vector<TypeRule> builtin = {
+        {"TH3", Histo3D, nullptr},
+        {"TH2", Histo2D, nullptr},
+        {"TH1", Histo1D, nullptr},
+        {"TGraph", Graph1D, nullptr},
+        {"TGraph2D", Graph2D, nullptr},
+        {"TMultiGraph", MultiGraph1D, nullptr},
+        {"THStack", MultiHisto1D, nullptr},
+        {"TF2", Function2D, nullptr},
+        {"TF1", Function1D, nullptr},
+        {"TPaveText", TextBox, nullptr},
+        {"TText", BareText, nullptr},
+        {"TLegend", Legend, nullptr},
+        {"TLine", Line, nullptr},
+        // {"TBox", Box, nullptr},
+        // {"TEllipse", Ellipse, nullptr},
+    };
+    std::unordered_map<const TClass*, DataType> cache;
+    std::mutex mutex;
+
+    DataType Resolve(const TClass* cl) {
+        for (auto rules : {&user, &builtin}) {
+            for (auto& rule : *rules) {
+                if (!rule.cl) rule.cl = TClass::GetClass(rule.name);
+                if (rule.cl && cl->InheritsFrom(rule.cl)) return rule.type;
+            }
         }
-        return Function1D;
-    }
-    else if (obj->InheritsFrom("TPaveText")) {
-        return TextBox;
+        return Undefined;
     }
-    else if (obj->InheritsFrom("TText")) {
-        return BareText;
-    }
-    else if (obj->InheritsFrom("TLegend")) {
-        return Legend;
-    }
-    else if (obj->InheritsFrom("TLine")) {
-        return Line;
-    }
-    // else if (obj->InheritsFrom("TBox")) {
-    //     return Box;
-    // }
-    // else if (obj->InheritsFrom("TEllipse")) {
-    //     return Ellipse;
-    // }
-    return Undefined;
+};
+
+TypeRegistry& GetRegistry() {
+    static TypeRegistry registry;
+    return registry;
+}
+
+} // namespace
+
+DataType GetDataType(const TObject* obj) {
+    return obj ? GetDataType(obj->IsA()) : Undefined;
+}
+
+/// @brief Data type of the objects of a class (the result is cached for each class)
+DataType GetDataType(const TClass* cl) {
+    if (!cl) return Undefined;
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto it = registry.cache.find(cl);
+    if (it != registry.cache.end()) return it->second;
+    DataType type = registry.Resolve(cl);
+    registry.cache.emplace(cl, type);
+    return type;
+}
+
+/// @brief Export the objects of a user class (and of its derived classes) as a given data type
+///
+/// The class must inherit from the ROOT class of this type (e.g. TH1 for Histo1D), since the objects are cast to it.
+/// The registered classes are checked before the ROOT ones, the last registered first.
+/// @return false if the class is not found
+bool RegisterDataType(const char* class_name, DataType type) {
+    TClass* cl = TClass::GetClass(class_name);
+    if (!cl) return false;
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.user.insert(registry.user.begin(), {cl->GetName(), type, cl});
+    registry.cache.clear();
+    return true;
 }
 
 int GetDataDimension(DataType d) {
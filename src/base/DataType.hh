@@ -1,6 +1,7 @@
 #ifndef DATATYPE_HH
 #define DATATYPE_HH
 
+class TClass;
 class TObject;
 
 namespace REx {
@@ -25,6 +26,8 @@ enum DataType {
 };
 
 DataType GetDataType(const TObject* obj);
+DataType GetDataType(const TClass* cl);
+bool RegisterDataType(const char* class_name, DataType type);
 
 int GetDataDimension(DataType d);
 
@@ -0,0 +1,106 @@
+#include "Decimation.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace REx {
+
+bool operator==(const PixelColumns& lc, const PixelColumns& rc) {
+    return lc.n == rc.n && lc.xmin == rc.xmin && lc.xmax == rc.xmax && lc.logx == rc.logx;
+}
+
+bool operator!=(const PixelColumns& lc, const PixelColumns& rc) {
+    return !(lc == rc);
+}
+
+/// @brief Select the points of a line plot to keep at a given resolution (M4 decimation)
+///
+/// In each pixel column, the first, last, lowest and highest points are kept: the polyline through the kept points
+/// covers the same pixels as the polyline through all the points. Outside the visible x range, only the points next
+/// to the edges are kept, so that the lines leaving the plot are drawn. With a logarithmic axis, the columns are
+/// evenly spaced in log(x) and the points with x <= 0 are dropped (they are not drawn).
+/// @param x, y coordinates of the points
+/// @param order indices of the points sorted by x (nullptr: the points are already sorted)
+/// @param n number of points
+/// @param columns resolution and visible x range (nothing is dropped if it is not valid)
+/// @return indices of the kept points, sorted by x
+std::vector<int> SelectM4(const double* x, const double* y, const int* order, int n, const PixelColumns& columns) {
+    std::vector<int> kept;
+    auto index = [order](int i) { return order ? order[i] : i; };
+    if (!columns.IsValid() || n <= 4 * columns.n) {
+        kept.resize(n);
+        for (int i = 0; i < n; i++)
+            kept[i] = index(i);
+        return kept;
+    }
+    kept.reserve(4 * columns.n + 2);
+
+    auto coord = [&columns](double v) { return columns.logx ? std::log10(v) : v; };
+    const double umin = coord(columns.xmin);
+    const double scale = columns.n / (coord(columns.xmax) - umin);
+    int before = -1; // last point before the visible range
+    int i = 0;
+    while (i < n && !(x[index(i)] >= columns.xmin)) {
+        if (!columns.logx || x[index(i)] > 0) before = index(i);
+        i++;
+    }
+    if (before >= 0) kept.push_back(before);
+
+    // points of the current column: first, last, lowest and highest (by position in the sorted order)
+    int column = -1;
+    int first = 0, last = 0, low = 0, high = 0;
+    auto flush = [&]() {
+        int pos[4] = {first, low, high, last};
+        std::sort(pos, pos + 4);
+        for (int k = 0; k < 4; k++)
+            if (k == 0 || pos[k] != pos[k - 1]) kept.push_back(index(pos[k]));
+    };
+    for (; i < n && x[index(i)] <= columns.xmax; i++) {
+        const int k = index(i);
+        int c = std::min(columns.n - 1, static_cast<int>((coord(x[k]) - umin) * scale));
+        if (c != column) {
+            if (column >= 0) flush();
+            column = c;
+            first = low = high = i;
+        }
+        last = i;
+        if (y[k] < y[index(low)]) low = i;
+        if (y[k] > y[index(high)]) high = i;
+    }
+    if (column >= 0) flush();
+    if (i < n) kept.push_back(index(i)); // first point after the visible range (or NaN)
+    return kept;
+}
+
+/// @brief Reduce a list of points sorted by x (next level of a level-of-detail pyramid)
+///
+/// The first, last, lowest and highest points of each block of consecutive points are kept: with blocks of 16
+/// points, the list is reduced by 4. Unlike SelectM4, the result does not depend on the visible range.
+/// @param y y coordinates of the points
+/// @param points indices of the points, sorted by x
+/// @param block number of points per block (>= 4)
+/// @return indices of the kept points, sorted by x
+std::vector<int> ReduceM4(const double* y, const std::vector<int>& points, int block) {
+    std::vector<int> kept;
+    const int n = points.size();
+    kept.reserve(4 * (n / block + 1));
+    for (int begin = 0; begin < n; begin += block) {
+        const int end = std::min(n, begin + block);
+        if (end - begin <= 4) {
+            kept.insert(kept.end(), points.begin() + begin, points.begin() + end);
+            continue;
+        }
+        int low = begin, high = begin;
+        for (int i = begin + 1; i < end; i++) {
+            if (y[points[i]] < y[points[low]]) low = i;
+            if (y[points[i]] > y[points[high]]) high = i;
+        }
+        int pos[4] = {begin, low, high, end - 1};
+        std::sort(pos, pos + 4);
+        for (int k = 0; k < 4; k++)
+            if (k == 0 || pos[k] != pos[k - 1]) kept.push_back(points[pos[k]]);
+    }
+    return kept;
+}
+
+} // namespace REx
@@ -0,0 +1,25 @@
+#ifndef DECIMATION_HH
+#define DECIMATION_HH
+
+#include <vector>
+
+namespace REx {
+
+/// @brief Pixel columns of the area where the data is plotted, for the min/max decimation of large graphs
+struct PixelColumns {
+    int n = 0;         // number of columns (width of the frame in pixels), 0: no decimation
+    double xmin = 0;   // visible x range
+    double xmax = 0;
+    bool logx = false; // logarithmic x axis
+    inline bool IsValid() const { return n > 0 && xmin < xmax && (!logx || xmin > 0); }
+};
+
+bool operator==(const PixelColumns& lc, const PixelColumns& rc);
+bool operator!=(const PixelColumns& lc, const PixelColumns& rc);
+
+std::vector<int> SelectM4(const double* x, const double* y, const int* order, int n, const PixelColumns& columns);
+std::vector<int> ReduceM4(const double* y, const std::vector<int>& points, int block = 16);
+
+} // namespace REx
+
+#endif
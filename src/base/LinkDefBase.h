@@ -11,6 +11,10 @@
 #pragma link C++ namespace REx;
 #pragma link C++ enum REx::DataType;
 #pragma link C++ function REx::GetDataType;
+#pragma link C++ function REx::RegisterDataType;
 #pragma link C++ function REx::GetDataDimension;
+#pragma link C++ struct REx::PixelColumns+;
+#pragma link C++ function REx::SelectM4;
+#pragma link C++ function REx::ReduceM4;
 
 #endif // __CINT__ / __CLING__
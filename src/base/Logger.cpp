@@ -0,0 +1,274 @@
+#include "Logger.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+int64_t NowMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+const char* kLevelNames[] = {"DEBUG", "INFO", "WARNING", "ERROR"};
+const char* kLevelColors[] = {"\033[01;36m", "\033[01;32m", "\033[01;33m", "\033[01;31m"};
+
+/// @brief Escape a string for JSON
+std::string JsonEscape(const std::string& str) {
+    std::string out;
+    out.reserve(str.size() + 2);
+    for (char c : str) {
+        switch (c) {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                }
+                else
+                    out += c;
+        }
+    }
+    return out;
+}
+
+/// @brief Write the last messages and the suppressed counts before exit
+void StopLogger() {
+    REx::Logger::GetInstance()->SetAsync(false);
+    REx::Logger::GetInstance()->Flush();
+}
+
+} // namespace
+
+namespace REx {
+
+LogSite::LogSite(const char* file, int line)
+    : file_(file), line_(line), count_(0), suppressed_(0), pending_(0), window_(0), inWindow_(0), next_(nullptr) {
+    Logger::GetInstance()->RegisterSite(this);
+}
+
+/// @brief Count a message, and check if it can be written (rate limit, except for the errors)
+bool LogSite::Allow(int level) {
+    count_++;
+    unsigned int limit = Logger::GetRateLimit();
+    if (!limit || level >= Logger::kError) return true;
+    int64_t now = NowMs();
+    int64_t start = window_.load(std::memory_order_relaxed);
+    if (now - start >= 1000 && window_.compare_exchange_strong(start, now))
+        inWindow_ = 0;
+    if (inWindow_++ < limit) return true;
+    suppressed_++;
+    pending_++;
+    return false;
+}
+
+std::atomic<int> Logger::level_(Logger::kDebug);
+std::atomic<unsigned int> Logger::rate_(20);
+
+Logger::Logger()
+    : cells_(new Cell[kCapacity]), tail_(0), head_(0), pushed_(0), written_(0),
+      async_(false), running_(false), colors_(true), console_(true), sites_(nullptr) {
+    for (size_t i = 0; i < kCapacity; i++)
+        cells_[i].seq = i;
+    std::atexit(StopLogger);
+}
+
+Logger* Logger::GetInstance() {
+    // function-local static : the logger may be used during the static initialization of other objects
+    static Logger* instance = new Logger();
+    return instance;
+}
+
+void Logger::RegisterSite(LogSite* site) {
+    LogSite* head = sites_.load();
+    do {
+        site->next_ = head;
+    } while (!sites_.compare_exchange_weak(head, site));
+}
+
+/// @brief Write a message (or queue it in asynchronous mode)
+void Logger::Log(Level level, LogSite& site, std::string msg) {
+    uint64_t suppressed = site.TakePending();
+    if (suppressed)
+        msg += " [" + std::to_string(suppressed) + " similar messages suppressed]";
+    Record rec{level, &site, NowMs(), std::move(msg)};
+    bool queued = async_;
+    if (queued) {
+        // counted before checking the mode again: SetAsync(false) waits for this message, or it is written here
+        pushed_++;
+        if (!async_) {
+            pushed_--;
+            queued = false;
+        }
+    }
+    if (!queued) {
+        Write(rec);
+        return;
+    }
+    while (!Push(rec)) {
+        // queue full : wait for the background thread
+        wake_.notify_one();
+        std::this_thread::yield();
+    }
+}
+
+bool Logger::Push(Record& rec) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+        cell = &cells_[pos & (kCapacity - 1)];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+            return false; // full
+        else
+            pos = tail_.load(std::memory_order_relaxed);
+    }
+    cell->rec = std::move(rec);
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+/// @brief Get the next message (background thread only)
+bool Logger::Pop(Record& rec) {
+    Cell* cell = &cells_[head_ & (kCapacity - 1)];
+    if (cell->seq.load(std::memory_order_acquire) != head_ + 1)
+        return false;
+    rec = std::move(cell->rec);
+    cell->seq.store(head_ + kCapacity, std::memory_order_release);
+    head_++;
+    return true;
+}
+
+void Logger::Write(const Record& rec) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (console_) {
+        std::ostream& os = rec.level >= kWarning ? std::cerr : std::cout;
+        if (colors_)
+            os << kLevelColors[rec.level] << "[" << kLevelNames[rec.level] << "]\033[0m " << rec.msg << '\n';
+        else
+            os << "[" << kLevelNames[rec.level] << "] " << rec.msg << '\n';
+        if (rec.level >= kWarning) os.flush();
+    }
+
+    if (json_.is_open()) {
+        json_ << "{\"time\":" << rec.time
+              << ",\"level\":\"" << kLevelNames[rec.level] << "\""
+              << ",\"file\":\"" << JsonEscape(rec.site->GetFile()) << "\""
+              << ",\"line\":" << rec.site->GetLine()
+              << ",\"msg\":\"" << JsonEscape(rec.msg) << "\"}\n";
+    }
+}
+
+/// @brief Background thread : write the queued messages
+void Logger::Drain() {
+    Record rec;
+    while (running_ || written_ < pushed_) {
+        bool any = false;
+        while (Pop(rec)) {
+            Write(rec);
+            written_++;
+            any = true;
+        }
+        if (!any) {
+            std::unique_lock<std::mutex> lock(wait_mutex_);
+            wake_.wait_for(lock, std::chrono::milliseconds(5));
+        }
+    }
+    std::cout.flush();
+}
+
+/// @brief Write the messages from a background thread (true), or immediately (false)
+///
+/// Other threads can log while the mode is switched, but this function must not be called from several threads.
+void Logger::SetAsync(bool async) {
+    if (async == async_) return;
+    if (async) {
+        running_ = true;
+        async_ = true;
+        thread_ = std::thread(&Logger::Drain, this);
+    }
+    else {
+        async_ = false;
+        running_ = false;
+        wake_.notify_one();
+        if (thread_.joinable()) thread_.join();
+        // messages queued by the threads that saw the asynchronous mode before the switch
+        Record rec;
+        while (written_ < pushed_) {
+            if (Pop(rec)) {
+                Write(rec);
+                written_++;
+            }
+            else
+                std::this_thread::yield();
+        }
+    }
+}
+
+/// @brief Wait until all the queued messages are written, then report the messages suppressed since the last
+/// message of their site (called at exit)
+void Logger::Flush() {
+    while (async_ && written_ < pushed_) {
+        wake_.notify_one();
+        std::this_thread::yield();
+    }
+    ReportSuppressed();
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    std::cout.flush();
+    std::cerr.flush();
+    if (json_.is_open()) json_.flush();
+}
+
+/// @brief Write one warning per site with suppressed messages not reported yet
+void Logger::ReportSuppressed() {
+    for (LogSite* s = sites_.load(); s; s = s->GetNext()) {
+        uint64_t suppressed = s->TakePending();
+        if (!suppressed) continue;
+        const char* file = strrchr(s->GetFile(), '/');
+        std::string msg = std::string(file ? file + 1 : s->GetFile()) + ":" + std::to_string(s->GetLine()) + ": " +
+                          std::to_string(suppressed) + " similar messages suppressed";
+        Write(Record{kWarning, s, NowMs(), std::move(msg)});
+    }
+}
+
+/// @brief Also write the messages as JSON lines in a file (empty name : close the file)
+bool Logger::SetJsonFile(const char* filename) {
+    Flush();
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (json_.is_open()) json_.close();
+    if (!filename || !filename[0]) return true;
+    json_.open(filename, std::ios::out | std::ios::app);
+    return json_.is_open();
+}
+
+/// @brief Print the number of messages per site, for the sites with suppressed messages
+void Logger::PrintSummary() const {
+    for (const LogSite* s = sites_.load(); s; s = s->GetNext()) {
+        if (!s->GetSuppressed()) continue;
+        const char* file = strrchr(s->GetFile(), '/');
+        std::cout << (file ? file + 1 : s->GetFile()) << ":" << s->GetLine() << " : "
+                  << s->GetCount() << " messages (" << s->GetSuppressed() << " suppressed)" << std::endl;
+    }
+}
+
+} // namespace REx
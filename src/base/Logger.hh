@@ -0,0 +1,141 @@
+#ifndef LOGGER_HH
+#define LOGGER_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace REx {
+
+/// @brief Location of a LOG_* macro in the code, with its counters (one static instance per call site)
+///
+/// The number of warnings and lower messages per site is limited to Logger::GetRateLimit() per second (the errors
+/// are never suppressed); the messages above this limit are counted and reported with the next message of the site,
+/// or by Logger::Flush.
+class LogSite {
+public:
+    LogSite(const char* file, int line);
+
+    bool Allow(int level);
+    inline const char* GetFile() const { return file_; };
+    inline int GetLine() const { return line_; };
+    inline uint64_t GetCount() const { return count_; };
+    inline uint64_t GetSuppressed() const { return suppressed_; };
+    inline uint64_t GetPending() const { return pending_; };
+    inline uint64_t TakePending() { return pending_.exchange(0); };
+    inline LogSite* GetNext() const { return next_; };
+
+private:
+    friend class Logger;
+    const char* file_;
+    int line_;
+    std::atomic<uint64_t> count_;      // number of messages
+    std::atomic<uint64_t> suppressed_; // number of messages not written (rate limit)
+    std::atomic<uint64_t> pending_;    // suppressed messages not reported yet
+    std::atomic<int64_t> window_;      // start of the current rate-limit window (ms)
+    std::atomic<unsigned int> inWindow_; // number of messages in the current window
+    LogSite* next_;                    // all sites are chained, for the summary
+};
+
+/// @brief Logging subsystem behind the LOG_* macros
+///
+/// Messages below the runtime level are discarded before being formatted.
+/// In asynchronous mode, the messages are pushed to a lock-free queue and written by a background thread.
+/// Messages can also be written as JSON lines in a file (machine-readable sink).
+class Logger {
+public:
+    enum Level {
+        kDebug = 0,
+        kInfo = 1,
+        kWarning = 2,
+        kError = 3,
+        kOff = 4
+    };
+
+    static Logger* GetInstance();
+
+    static inline void SetLevel(Level level) { level_ = level; };
+    static inline Level GetLevel() { return (Level)level_.load(std::memory_order_relaxed); };
+    static inline bool IsEnabled(Level level) { return level >= level_.load(std::memory_order_relaxed); };
+    static inline void SetRateLimit(unsigned int n) { rate_ = n; };
+    static inline unsigned int GetRateLimit() { return rate_.load(std::memory_order_relaxed); };
+
+    void Log(Level level, LogSite& site, std::string msg);
+    void SetAsync(bool async);
+    inline bool IsAsync() const { return async_; };
+    void Flush();
+    bool SetJsonFile(const char* filename);
+    inline void SetColors(bool colors) { colors_ = colors; };
+    inline void SetConsole(bool console) { console_ = console; };
+    void PrintSummary() const;
+
+    LogSite* GetSites() const { return sites_.load(); };
+    void RegisterSite(LogSite* site);
+
+private:
+    Logger();
+    Logger(const Logger&) = delete;
+
+    struct Record {
+        Level level;
+        const LogSite* site;
+        int64_t time; // ms since epoch
+        std::string msg;
+    };
+
+    bool Push(Record& rec);
+    bool Pop(Record& rec);
+    void Write(const Record& rec);
+    void Drain();
+    void ReportSuppressed();
+
+private:
+    static std::atomic<int> level_;
+    static std::atomic<unsigned int> rate_;
+
+    // bounded multi-producer queue (sequence number per cell)
+    struct Cell {
+        std::atomic<size_t> seq;
+        Record rec;
+    };
+    static const size_t kCapacity = 4096; // power of 2
+    std::unique_ptr<Cell[]> cells_;
+    std::atomic<size_t> tail_; // next cell to write (producers)
+    size_t head_;              // next cell to read (consumer)
+    std::atomic<uint64_t> pushed_;
+    std::atomic<uint64_t> written_;
+
+    std::atomic<bool> async_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+    std::mutex wait_mutex_;
+    std::condition_variable wake_;
+
+    bool colors_;
+    bool console_; // write in std::cout / std::cerr
+    std::mutex write_mutex_; // output streams
+    std::ofstream json_;
+    std::atomic<LogSite*> sites_;
+};
+
+} // namespace REx
+
+/// @brief Log a message at the given level (msg may be a stream expression: "a " << b)
+#define REX_LOG(level, msg)                                                                      \
+    do {                                                                                         \
+        if (REx::Logger::IsEnabled(level)) {                                                     \
+            static REx::LogSite rex_log_site(__FILE__, __LINE__);                                \
+            if (rex_log_site.Allow(level)) {                                                     \
+                std::ostringstream rex_log_os;                                                   \
+                rex_log_os << msg;                                                               \
+                REx::Logger::GetInstance()->Log(level, rex_log_site, rex_log_os.str());          \
+            }                                                                                    \
+        }                                                                                        \
+    } while (0)
+
+#endif
@@ -1,18 +1,35 @@
 #include "ExportManager.hh"
 
+#include "BoundedQueue.hh"
+#include "DataScan.hh"
 #include "Log.hh"
+#include "PathResolver.hh"
+#include "PlotBuilder.hh"
 #include "PlotSerializer.hh"
 #include "ROOTToText.hh"
 
 #include "TClass.h"
 #include "TGraph.h"
 #include "TH1.h"
+#include "THStack.h"
+#include "TROOT.h"
 #include "TSystem.h"
 #include "TVirtualPad.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
 
 namespace REx {
 
@@ -23,22 +40,559 @@ BaseExportManager::BaseExportManager() {
     inFolder_ = false;
     verb_ = false;
     saveListFunc_ = true;
+    snapshot_ = false;
+    decimate_ = false;
+    lod_ = false;
+    contentType_ = "text/plain";
+    sink_ = FileSink::GetInstance();
 }
 
 BaseExportManager::~BaseExportManager() {
 }
 
+/// @brief Plot captured for export: serialized plot, format of the data files and output paths
+struct ExportJob {
+    // data files written in the same folder, with the same format, are shared
+    struct Group {
+        const BaseExportManager* writer; // manager saving the data
+        TString folder;
+        PadProperties pp;
+        std::vector<std::pair<const BaseExportManager*, TString>> scripts;
+    };
+    std::unique_ptr<PlotSerializer> ps;
+    std::vector<std::vector<std::pair<TString, int>>> formats; // RTT option ; number of columns (per pad and per dataset)
+    std::vector<Group> groups;
+    TString name; // pad name
+    bool ok = true;
+};
+
+namespace {
+
+/// @brief Background thread running the asynchronous exports, in submission order
+///
+/// The thread is stopped by an exit handler, registered with the first export: the pending exports are finished
+/// before ROOT and gRTT are destroyed (their static objects were constructed before the registration).
+class ExportExecutor {
+public:
+    static ExportExecutor& GetInstance() {
+        static ExportExecutor instance;
+        return instance;
+    }
+
+    void Submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stop_) throw std::runtime_error("ExportPadAsync: the program is exiting");
+            tasks_.push_back(std::move(task));
+            if (!thread_.joinable()) {
+                static bool registered = false;
+                if (!registered) std::atexit([] { ExportExecutor::GetInstance().Stop(); });
+                registered = true;
+                thread_ = std::thread(&ExportExecutor::Run, this);
+            }
+        }
+        cv_.notify_one();
+    }
+
+    /// @brief Wait until the submitted exports are finished
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return tasks_.empty() && !running_; });
+    }
+
+    /// @brief Finish the pending exports and join the thread
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    ~ExportExecutor() {
+        Stop();
+    }
+
+private:
+    ExportExecutor() : running_(false), stop_(false) {};
+
+    void Run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+            if (tasks_.empty()) return; // stop_
+            auto task = std::move(tasks_.front());
+            tasks_.pop_front();
+            running_ = true;
+            lock.unlock();
+            task();
+            lock.lock();
+            running_ = false;
+            idle_.notify_all();
+        }
+    }
+
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable idle_; // a task is finished
+    std::thread thread_;
+    bool running_;
+    bool stop_;
+};
+
+std::mutex rttMutex; // the gRTT settings are changed while the data files are written
+
+/// @brief Restore the gRTT settings (sink, directory, comment character, verbosity) at the end of the scope
+///
+/// Created under rttMutex, before the settings are changed: they are restored also if the export throws.
+class RTTSettingsGuard {
+public:
+    RTTSettingsGuard()
+        : folder_(gRTT->GetDirectory()), cc_(gRTT->GetCommentChar()), verb_(gRTT->GetVerbose()), sink_(gRTT->GetOutputSink()) {};
+
+    ~RTTSettingsGuard() {
+        gRTT->SetOutputSink(sink_); // before SetDirectory (the directory is checked by the sink)
+        gRTT->SetCommentChar(cc_);
+        gRTT->SetVerbose(verb_);
+        try {
+            gRTT->SetDirectory(folder_);
+        } catch (const std::exception& ex) {
+            LOG_ERROR("Could not restore the ROOTToText directory " << folder_ << ": " << ex.what());
+        }
+    }
+
+    RTTSettingsGuard(const RTTSettingsGuard&) = delete;
+    RTTSettingsGuard& operator=(const RTTSettingsGuard&) = delete;
+
+private:
+    TString folder_;
+    char cc_;
+    bool verb_;
+    OutputSink* sink_;
+};
+
+} // namespace
+
 /// @brief Save plot to text files (plotting script with data files)
 /// @param pad plot to export
 /// @param filename ouput script name
 void BaseExportManager::ExportPad(TVirtualPad* pad, const char* filename) const {
-    auto ps = std::make_unique<PlotSerializer>(pad, saveListFunc_);
+    ExportPad(pad, filename, {this});
+}
+
+/// @brief Save a plot with several export managers: the plot is serialized once, and each data file is written once
+///
+/// The data files are shared by the managers that write them in the same folder with the same comment character
+/// (e.g. gnuplot and matplotlib scripts in the same directory). The managers that ignore the list of functions
+/// (see IgnoreListOfFunctions) and the other ones use separate serializations.
+/// @param pad plot to export
+/// @param filename ouput script name (the extension of each manager is added)
+/// @param managers export managers (not owned)
+/// @return false if a file could not be written
+bool BaseExportManager::ExportPad(TVirtualPad* pad, const char* filename, const std::vector<const BaseExportManager*>& managers) {
+    auto lists = SplitBySaveFunctions(managers);
+    bool ok = !lists.empty();
+    for (const auto& list : lists) {
+        auto job = PrepareExport(pad, filename, list);
+        ok = job && RunExport(*job) && ok;
+    }
+    return ok;
+}
+
+/// @brief Save a plot described without pad to text files (plotting script with data files)
+///
+/// Nothing is drawn: the plot properties are taken from the description and the objects (see PlotBuilder).
+/// @param plot plot description
+/// @param filename ouput script name (default: plot name)
+/// @return false if a file could not be written
+bool BaseExportManager::ExportPlot(const PlotBuilder& plot, const char* filename) const {
+    return ExportPlot(plot, filename, {this});
+}
+
+/// @brief Save a plot described without pad with several export managers (see ExportPad)
+/// @param plot plot description
+/// @param filename ouput script name (the extension of each manager is added)
+/// @param managers export managers (not owned)
+/// @return false if a file could not be written
+bool BaseExportManager::ExportPlot(const PlotBuilder& plot, const char* filename, const std::vector<const BaseExportManager*>& managers) {
+    auto lists = SplitBySaveFunctions(managers);
+    bool ok = !lists.empty();
+    for (const auto& list : lists) {
+        auto job = PrepareExport(std::make_unique<PlotSerializer>(plot, list[0]->saveListFunc_), filename, list);
+        ok = job && RunExport(*job) && ok;
+    }
+    return ok;
+}
+
+/// @brief Save plot to text files in a background thread
+///
+/// The plot is serialized and its data objects are copied before returning:
+/// the objects drawn in the pad can be modified or deleted right after the call.
+/// The export manager must not be modified or deleted until the export is finished.
+/// @param pad plot to export
+/// @param filename ouput script name
+/// @return true when the export is finished, if all the files were written
+std::future<bool> BaseExportManager::ExportPadAsync(TVirtualPad* pad, const char* filename) const {
+    ROOT::EnableThreadSafety();
+    std::shared_ptr<ExportJob> job = PrepareExport(pad, filename, {this});
+    if (job) job->ps->CloneData();
+    auto task = std::make_shared<std::packaged_task<bool()>>([job]() { return job && RunExport(*job); });
+    auto res = task->get_future();
+    ExportExecutor::GetInstance().Submit([task]() { (*task)(); });
+    return res;
+}
+
+/// @brief Wait until all the exports started by ExportPadAsync (any manager) are finished
+///
+/// The pending exports are also finished at exit, before ROOT is shut down; call this function before deleting the
+/// export managers, sinks or output settings used by the asynchronous exports.
+void BaseExportManager::WaitForExports() {
+    ExportExecutor::GetInstance().Wait();
+}
 
-    auto path = GetFilePath(pad, filename);
-    TString folder = gSystem->DirName(path);
+/// @brief Split a list of export managers by the serialization they need (with or without the list of functions)
+/// @return one or two lists of managers, without the null ones (empty if there is no manager)
+std::vector<std::vector<const BaseExportManager*>> BaseExportManager::SplitBySaveFunctions(const std::vector<const BaseExportManager*>& managers) {
+    std::vector<const BaseExportManager*> with_func, without_func;
+    for (auto man : managers) {
+        if (!man) continue;
+        (man->saveListFunc_ ? with_func : without_func).push_back(man);
+    }
+    std::vector<std::vector<const BaseExportManager*>> lists;
+    if (!with_func.empty()) lists.push_back(std::move(with_func));
+    if (!without_func.empty()) lists.push_back(std::move(without_func));
+    return lists;
+}
+
+/// @brief Serialize a plot and get the output paths (first step of an export, in the thread of the pad)
+///
+/// The plot is serialized with the setting of the first manager (see SplitBySaveFunctions).
+/// @param fingerprints fingerprints of the objects of the pad already computed, if any (see ComputePadHash)
+/// @return nullptr if there is nothing to export
+std::unique_ptr<ExportJob> BaseExportManager::PrepareExport(TVirtualPad* pad, const char* filename, const std::vector<const BaseExportManager*>& managers, const FingerprintCache* fingerprints) {
+    if (managers.empty() || !pad) return nullptr;
+    return PrepareExport(std::make_unique<PlotSerializer>(pad, managers[0]->saveListFunc_, fingerprints), filename, managers);
+}
+
+/// @brief Get the output paths of a serialized plot (the drawing options are read from its pad, if any)
+std::unique_ptr<ExportJob> BaseExportManager::PrepareExport(std::unique_ptr<PlotSerializer> serializer, const char* filename, const std::vector<const BaseExportManager*>& managers) {
+    auto job = std::make_unique<ExportJob>();
+    job->name = serializer->pp_.name;
+    job->ps = std::move(serializer);
+    SetDataFormats(*job);
+
+    auto& groups = job->groups;
+    for (auto man : managers) {
+        if (!man) continue;
+        TString path = man->GetFilePath(job->name, filename);
+        TString folder;
+        if (!man->GetDataFolder(path, folder)) {
+            job->ok = false;
+            continue;
+        }
+        ExportJob::Group* group = nullptr;
+        for (auto& g : groups) {
+            if (g.folder == folder && g.writer->com_ == man->com_ && g.writer->sink_ == man->sink_ && g.writer->dataDir_ == man->dataDir_ && g.writer->decimate_ == man->decimate_ && g.writer->lod_ == man->lod_) {
+                group = &g;
+                break;
+            }
+        }
+        if (!group) {
+            groups.push_back({man, folder, PadProperties(), {}});
+            group = &groups.back();
+        }
+        group->scripts.push_back({man, path});
+    }
+    return job;
+}
+
+/// @brief Get the format of the data files of a serialized plot (it depends on the drawing options, in the pad)
+void BaseExportManager::SetDataFormats(ExportJob& job) {
+    std::vector<std::pair<PlotSerializer*, PadProperties*>> all_pads;
+    GetAllPads(*job.ps, job.ps->pp_, all_pads);
+    job.formats.clear();
+    for (const auto& sub : all_pads) {
+        auto& ps = *sub.first;
+        job.formats.emplace_back();
+        for (int i = 0; i < (int)ps.dataObjects_.size(); i++) {
+            TString option = ps.pad_ ? TString(ps.dataObjects_[i]->GetDrawOption()) : ps.drawOptions_[i];
+            auto layer = ps.stackLayers_.find(i);
+            if (layer != ps.stackLayers_.end())
+                job.formats.back().push_back(GetDataFormat(ps.dataObjects_[i], ps.pp_.datasets[i], option, layer->second.first, layer->second.second));
+            else
+                job.formats.back().push_back(GetDataFormat(ps.dataObjects_[i], ps.pp_.datasets[i], option));
+        }
+    }
+}
+
+/// @brief Write the data files and the scripts of a serialized plot
+/// @return false if a file could not be written
+bool BaseExportManager::RunExport(ExportJob& job) {
+    WriteDataFiles(job);
+    return WriteScripts(job);
+}
+
+/// @brief Write the data files of a serialized plot (the file names are set in the plot properties of each group)
+bool BaseExportManager::WriteDataFiles(ExportJob& job) {
+    for (auto& g : job.groups) {
+        g.pp = job.ps->pp_;
+        job.ok = g.writer->SaveAllData(*job.ps, g.pp, g.folder, job.formats) && job.ok;
+    }
+    return job.ok;
+}
+
+/// @brief Serialize a plot again, and find the datasets whose data files can be kept
+///
+/// A data file is kept if the data of the dataset is the same as in the previous export (see PlotSerializer::Update),
+/// with the same format, and if it was written. The datasets of the subpads are always written.
+/// The plot properties of each group are set, with the names of the kept data files.
+/// @param job previous export of the plot (its serializer must have a pad)
+/// @param fingerprints fingerprints of the objects of the pad already computed, if any (see ComputePadHash)
+/// @return datasets of the main pad whose data file is kept
+std::vector<bool> BaseExportManager::PrepareUpdate(ExportJob& job, const FingerprintCache* fingerprints) {
+    auto& ps = *job.ps;
+    PixelColumns old_columns = ps.GetPixelColumns();
+    ps.Update(fingerprints);
+    auto old_formats = std::move(job.formats);
+    SetDataFormats(job);
+    // the decimated graphs are written again if the size of the frame or the visible range changed,
+    // the level-of-detail pyramids if the size of the frame changed (it sets their coarsest level)
+    bool redecimate = false;
+    if (ps.GetPixelColumns() != old_columns) {
+        for (const auto& g : job.groups)
+            redecimate = redecimate || g.writer->decimate_ || (g.writer->lod_ && ps.GetPixelColumns().n != old_columns.n);
+    }
+
+    // datasets of the main pad with the same data and format
+    const auto& formats = job.formats[0];
+    std::vector<int> previous(formats.size(), -1);
+    for (int i = 0; i < (int)formats.size(); i++) {
+        int prev = ps.GetPreviousIndex(i);
+        if (prev < 0 || old_formats.empty() || prev >= (int)old_formats[0].size() || old_formats[0][prev] != formats[i]) continue;
+        if (redecimate && ps.pp_.datasets[i].type == Graph1D) continue;
+        bool written = true;
+        for (const auto& g : job.groups)
+            written = written && prev < (int)g.pp.datasets.size() && !g.pp.datasets[prev].file.first.IsNull();
+        if (written) previous[i] = prev;
+    }
+    std::vector<bool> keep(formats.size());
+    for (size_t i = 0; i < formats.size(); i++)
+        keep[i] = previous[i] >= 0;
+
+    for (auto& g : job.groups) {
+        PadProperties pp = ps.pp_;
+        for (size_t i = 0; i < formats.size(); i++) {
+            if (keep[i]) pp.datasets[i].file = g.pp.datasets[previous[i]].file;
+        }
+        g.pp = std::move(pp);
+    }
+    return keep;
+}
+
+/// @brief Copy of a prepared export, to write its files in another thread
+/// @param keep datasets of the main pad whose data file is kept (their data objects are not copied)
+/// @param clone_data copy the data objects (otherwise the objects of the pad are used)
+std::unique_ptr<ExportJob> BaseExportManager::CopyExport(const ExportJob& job, const std::vector<bool>& keep, bool clone_data) {
+    auto copy = std::make_unique<ExportJob>();
+    copy->ps.reset(new PlotSerializer(*job.ps));
+    if (clone_data) copy->ps->CloneData(&keep);
+    copy->formats = job.formats;
+    copy->groups = job.groups;
+    copy->name = job.name;
+    copy->ok = job.ok;
+    return copy;
+}
+
+/// @brief Write the data files that are not kept, and the scripts of a prepared export (see PrepareUpdate)
+/// @return false if a file could not be written
+bool BaseExportManager::WriteUpdate(ExportJob& job, const std::vector<bool>& keep) {
+    for (auto& g : job.groups)
+        job.ok = g.writer->SaveAllData(*job.ps, g.pp, g.folder, job.formats, &keep) && job.ok;
+    return WriteScripts(job);
+}
+
+/// @brief Write the scripts (and snapshots) of a plot whose data files are written
+bool BaseExportManager::WriteScripts(ExportJob& job) {
+    for (auto& g : job.groups) {
+        for (const auto& script : g.scripts) {
+            if (script.first->snapshot_) {
+                job.ok = script.first->WriteSnapshot(script.second, g.pp) && job.ok; // one snapshot per group
+                break;
+            }
+        }
+        for (const auto& script : g.scripts) {
+            if (!script.first->WriteToFile(script.second, g.pp)) {
+                job.ok = false;
+                continue;
+            }
+            if (script.first->verb_) LOG_INFO("Saved plot from " << job.name << " in " << script.second);
+        }
+    }
+    return job.ok;
+}
+
+/// @brief Export a list of plots, with the serialization, the data files and the scripts in pipelined stages
+///
+/// The plots are serialized (and their data objects copied) in the calling thread, since ROOT graphics is not thread-safe.
+/// The data files and the scripts are written by two worker threads. The stages are connected by bounded queues:
+/// at most 2 x queue_size + 2 serialized plots are kept in memory, the serialization waits when the queues are full.
+/// @param pads plots to export
+/// @param filenames output script names (default: pad names)
+/// @param queue_size maximum number of plots waiting between two stages
+/// @return one result per pad, in the same order
+std::vector<ExportResult> BaseExportManager::ExportPads(const std::vector<TVirtualPad*>& pads, const std::vector<TString>& filenames, size_t queue_size) const {
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::time_point t0) { return std::chrono::duration<double, std::milli>(clock::now() - t0).count(); };
+
+    std::vector<ExportResult> results(pads.size());
+    if (!filenames.empty() && filenames.size() != pads.size())
+        throw std::invalid_argument("ExportPads: the number of file names does not match the number of pads");
+    ROOT::EnableThreadSafety();
+
+    struct Item {
+        size_t index;
+        std::unique_ptr<ExportJob> job;
+    };
+    BoundedQueue<Item> to_data(queue_size);
+    BoundedQueue<Item> to_script(queue_size);
+
+    // stage 2 : data files
+    std::thread data_stage([&]() {
+        Item item;
+        while (to_data.Pop(item)) {
+            auto t0 = clock::now();
+            try {
+                results[item.index].ok = WriteDataFiles(*item.job);
+            } catch (const std::exception& e) {
+                results[item.index].ok = false;
+                results[item.index].error = e.what();
+            }
+            results[item.index].dataTime = ms(t0);
+            to_script.Push(std::move(item));
+        }
+        to_script.Close();
+    });
+
+    // stage 3 : scripts
+    std::thread script_stage([&]() {
+        Item item;
+        while (to_script.Pop(item)) {
+            auto t0 = clock::now();
+            try {
+                results[item.index].ok = WriteScripts(*item.job) && results[item.index].ok;
+            } catch (const std::exception& e) {
+                results[item.index].ok = false;
+                results[item.index].error = e.what();
+            }
+            results[item.index].scriptTime = ms(t0);
+            item.job.reset(); // the copies of the data objects are deleted here
+        }
+    });
+
+    // stage 1 : serialization, in the calling thread
+    for (size_t i = 0; i < pads.size(); i++) {
+        auto& res = results[i];
+        auto t0 = clock::now();
+        std::unique_ptr<ExportJob> job;
+        try {
+            job = PrepareExport(pads[i], filenames.empty() ? "" : filenames[i].Data(), {this});
+            if (job) {
+                job->ps->CloneData();
+                res.pad = job->name;
+                if (!job->groups.empty()) res.filename = job->groups[0].scripts[0].second;
+            }
+            else
+                res.error = "no pad";
+        } catch (const std::exception& e) {
+            job.reset();
+            res.error = e.what();
+        }
+        res.serializeTime = ms(t0);
+        if (job)
+            to_data.Push({i, std::move(job)});
+        else
+            LOG_ERROR("Could not export pad " << i << ": " << res.error);
+    }
+    to_data.Close();
+    data_stage.join();
+    script_stage.join();
+    return results;
+}
+
+/// @param pad plot to export (not owned)
+/// @param filename ouput script name (the extension of each manager is added)
+/// @param managers export managers (not owned)
+IncrementalExport::IncrementalExport(TVirtualPad* pad, const char* filename, const std::vector<const BaseExportManager*>& managers)
+    : pad_(pad), filename_(filename), managers_(managers), nwritten_(0) {
+    if (!pad) throw std::invalid_argument("IncrementalExport: null pad");
+    if (BaseExportManager::SplitBySaveFunctions(managers).size() > 1)
+        LOG_WARN("IncrementalExport: the export managers do not agree on IgnoreListOfFunctions, the setting of the first one is used");
+}
+
+IncrementalExport::~IncrementalExport() {
+}
+
+/// @brief Export the pad: fully the first time, then only the modified objects and the data that changed
+/// @return false if a file could not be written
+bool IncrementalExport::Export() {
+    auto copy = Prepare(false);
+    return copy && Write(*copy);
+}
+
+/// @brief Serialize the pad (in its thread), and get a copy of the export with the data files to write
+/// @param clone_data copy the data objects to write (the files are written in another thread)
+/// @param fingerprints fingerprints of the objects of the pad already computed, if any (see ComputePadHash)
+/// @return nullptr if there is nothing to export
+std::unique_ptr<ExportJob> IncrementalExport::Prepare(bool clone_data, const FingerprintCache* fingerprints) {
+    if (job_) {
+        keep_ = BaseExportManager::PrepareUpdate(*job_, fingerprints);
+    }
+    else {
+        job_ = BaseExportManager::PrepareExport(pad_, filename_, managers_, fingerprints);
+        if (!job_) return nullptr;
+        for (auto& g : job_->groups)
+            g.pp = job_->ps->pp_;
+        keep_.assign(job_->formats[0].size(), false);
+    }
+    nwritten_ = std::count(keep_.begin(), keep_.end(), false);
+    for (size_t k = 1; k < job_->formats.size(); k++)
+        nwritten_ += job_->formats[k].size();
+    return BaseExportManager::CopyExport(*job_, keep_, clone_data);
+}
+
+/// @brief Write the files of a prepared export, and keep the names of the data files for the next export
+bool IncrementalExport::Write(ExportJob& copy) {
+    bool ok = BaseExportManager::WriteUpdate(copy, keep_);
+    for (size_t k = 0; k < copy.groups.size() && k < job_->groups.size(); k++)
+        job_->groups[k].pp = std::move(copy.groups[k].pp);
+    return ok;
+}
+
+/// @brief Serialize the pad (in its thread) and copy the data to write, for writing the files in another thread
+/// @param fingerprints fingerprints of the objects of the pad already computed, if any (see ComputePadHash)
+/// @return task writing the files (it must be run before the next export), empty if there is nothing to export
+std::function<bool()> IncrementalExport::PrepareAsync(const FingerprintCache* fingerprints) {
+    std::shared_ptr<ExportJob> copy = Prepare(true, fingerprints);
+    if (!copy) return nullptr;
+    return [this, copy]() { return Write(*copy); };
+}
+
+/// @brief Forget the previous export: the next one serializes the pad and writes all the files again
+void IncrementalExport::Reset() {
+    job_.reset();
+}
+
+/// @brief Check that the script can be written, and get the folder of the data files
+/// @param path script path (see GetFilePath)
+/// @param folder folder of the data files
+/// @return false if the script folder is not writable
+bool BaseExportManager::GetDataFolder(const TString& path, TString& folder) const {
+    folder = gSystem->DirName(path);
 
     if (ext_.Length()) {
-        if (!gSystem->AccessPathName(path, EAccessMode::kFileExists)) {
+        if (sink_->Exists(path)) {
             LOG_WARN("Overwriting file " << path);
         }
     }
@@ -46,46 +600,167 @@ void BaseExportManager::ExportPad(TVirtualPad* pad, const char* filename) const
         folder = path;
     }
 
-    if (gSystem->AccessPathName(folder, EAccessMode::kWritePermission)) {
+    if (!sink_->IsWritable(folder)) {
         LOG_ERROR("Cannot write to directory " << folder);
-        return;
+        return false;
         // throw std::runtime_error("Error: cannot write to this directory.")
     }
 
     if (!dataDir_.IsWhitespace())
         folder.Append("/").Append(dataDir_);
+    return true;
+}
+
+/// @brief Get a serialized pad and its subpads (depth-first), with the matching plot properties
+void BaseExportManager::GetAllPads(PlotSerializer& ps, PadProperties& pp, std::vector<std::pair<PlotSerializer*, PadProperties*>>& pads) {
+    pads.push_back({&ps, &pp});
+    for (size_t k = 0; k < ps.subpads_.size() && k < pp.subpads.size(); k++)
+        GetAllPads(*ps.subpads_[k], pp.subpads[k], pads);
+}
 
-    // save gRTT parameters
-    auto rtt_folder = gRTT->GetDirectory();
-    auto rtt_cc = gRTT->GetCommentChar();
-    auto rtt_verb = gRTT->GetVerbose();
+/// @brief Save all the data objects of a plot with ROOTToText
+///
+/// The data files of the subpads are written in parallel, and prefixed with the subpad name (e.g. "c1_1_h.txt").
+/// @param ps serialized plot
+/// @param pp plot properties, where the data file names are set
+/// @param folder folder of the data files
+/// @param formats RTT option and number of columns of each dataset, per pad (see GetDataFormat)
+/// @param keep datasets of the main pad whose data file is already written (the file name is set in pp)
+/// @return false if a data file could not be written
+bool BaseExportManager::SaveAllData(PlotSerializer& ps, PadProperties& pp, const TString& folder, const std::vector<std::vector<std::pair<TString, int>>>& formats, const std::vector<bool>* keep) const {
+    std::vector<std::pair<PlotSerializer*, PadProperties*>> pads;
+    GetAllPads(ps, pp, pads);
+
+    std::lock_guard<std::mutex> lock(rttMutex);
+    RTTSettingsGuard rtt_settings; // restored when the data files are written
+    gRTT->SetOutputSink(sink_); // before SetDirectory (the directory is checked by the sink)
     gRTT->SetDirectory(folder);
     gRTT->SetCommentChar(com_);
     gRTT->SetVerbose(verb_);
-    // std::cout << "RTT directory: " << gRTT->GetDirectory() << " (" << pad->GetName() << ")" << std::endl;
-    for (int i = 0; i < (int)ps->dataObjects_.size(); i++) {
-        SaveData(ps->dataObjects_[i], ps->pp_.datasets[i]);
+    // std::cout << "RTT directory: " << gRTT->GetDirectory() << std::endl;
+
+    // the gRTT settings are not modified until all the pads are saved
+    std::atomic<bool> ok(true);
+    auto save_pad = [&](size_t k) {
+        auto& sub = *pads[k].first;
+        auto& sub_pp = *pads[k].second;
+        for (int i = 0; i < (int)sub.dataObjects_.size(); i++) {
+            if (k == 0 && keep && (*keep)[i]) continue;
+            auto& data = sub_pp.datasets[i];
+            data.file.first = "";
+            if (k > 0) {
+                data.file.first.Append(sub_pp.name).Append('_').Append(sub.dataObjects_[i]->GetName());
+                data.file.first.ReplaceAll(' ', '_');
+            }
+            auto layer = sub.stackLayers_.find(i);
+            bool saved;
+            if (layer != sub.stackLayers_.end())
+                saved = SaveData(sub.dataObjects_[i], data, formats[k][i], layer->second.first, layer->second.second);
+            else
+                saved = SaveData(sub.dataObjects_[i], data, formats[k][i], nullptr, -1, &sub.columns_);
+            if (!saved) ok = false;
+        }
+    };
+    size_t nthreads = std::min<size_t>(pads.size(), std::max(1u, std::thread::hardware_concurrency()));
+    if (nthreads > 1) {
+        ROOT::EnableThreadSafety();
+        std::atomic<size_t> next(0);
+        std::exception_ptr error; // first exception of the workers, thrown again after the joins
+        std::mutex error_mutex;
+        auto worker = [&]() {
+            size_t k;
+            while ((k = next++) < pads.size()) {
+                try {
+                    save_pad(k);
+                } catch (...) {
+                    std::lock_guard<std::mutex> error_lock(error_mutex);
+                    if (!error) error = std::current_exception();
+                    ok = false;
+                }
+            }
+        };
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < nthreads; t++)
+            workers.emplace_back(worker);
+        worker();
+        for (auto& t : workers)
+            t.join();
+        if (error) std::rethrow_exception(error);
+    }
+    else {
+        for (size_t k = 0; k < pads.size(); k++)
+            save_pad(k);
+    }
+    return ok;
+}
+
+/// @brief Save the plot properties in a binary snapshot, next to the script ("foo/bar.ext" --> "foo/bar.rexp")
+/// @param path script path (a folder for DataExportManager: "foo" --> "foo/foo.rexp")
+/// @param pp plot properties, with the data file names
+/// @return false if the snapshot could not be written
+bool BaseExportManager::WriteSnapshot(const TString& path, const PadProperties& pp) const {
+    TString snapshot(path);
+    if (ext_.Length())
+        snapshot.Remove(snapshot.Length() - ext_.Length());
+    else
+        snapshot.Append("/").Append(gSystem->BaseName(path));
+    snapshot.Append(".rexp");
+
+    std::ofstream ofs;
+    if (!sink_->Open(snapshot, ofs, std::ios_base::out | std::ios_base::binary)) {
+        LOG_ERROR("Could not open file " << snapshot);
+        return false;
+    }
+    pp.WriteSnapshot(ofs);
+    if (!sink_->Close(snapshot, ofs, "application/octet-stream")) {
+        LOG_ERROR("Could not write file " << snapshot);
+        return false;
     }
-    // restore gRTT parameters
-    gRTT->SetDirectory(rtt_folder);
-    gRTT->SetCommentChar(rtt_cc);
-    gRTT->SetVerbose(rtt_verb);
+    return true;
+}
 
-    WriteToFile(path, ps->pp_);
+/// @brief Write a script from a snapshot saved by ExportPad (see EnableSnapshot), without any ROOT object
+///
+/// The data file names are relative to the folder of the original script:
+/// the new script should be written in the same folder to use them.
+/// @param snapshot snapshot file (*.rexp)
+/// @param filename output script name (default: snapshot name with the extension of this manager)
+/// @return false if the snapshot could not be read or the script could not be written
+bool BaseExportManager::ExportSnapshot(const char* snapshot, const char* filename) const {
+    std::ifstream ifs(snapshot, std::ios_base::in | std::ios_base::binary);
+    if (!ifs) {
+        LOG_ERROR("Could not open file " << snapshot);
+        return false;
+    }
+    PadProperties pp;
+    if (!pp.ReadSnapshot(ifs)) {
+        LOG_ERROR("Could not read snapshot " << snapshot);
+        return false;
+    }
 
-    if (verb_) LOG_INFO("Saved plot from " << pad->GetName() << " in " << path);
+    TString name(filename);
+    if (name.IsWhitespace()) {
+        name = snapshot;
+        if (name.EndsWith(".rexp")) name.Remove(name.Length() - 5);
+    }
+    TString path = GetFilePath(pp.name, name);
+    TString folder;
+    if (!GetDataFolder(path, folder)) return false;
+    if (!WriteToFile(path, pp)) return false;
+    if (verb_) LOG_INFO("Saved plot from " << snapshot << " in " << path);
+    return true;
 }
 
 /// @brief Get the ouput file path for exporting a plot
-/// @param pad plot to export
+/// @param name plot name (default file name)
 /// @param filename output file name
 /// @return output file path
-TString BaseExportManager::GetFilePath(TVirtualPad* pad, const char* filename) const {
+TString BaseExportManager::GetFilePath(const char* name, const char* filename) const {
     TString str(filename);
 
-    // if no filename is given, use the object name
+    // if no filename is given, use the plot name
     if (str.IsWhitespace()) {
-        str = pad->GetName();
+        str = name;
         str.ReplaceAll(' ', '_');
     }
 
@@ -95,7 +770,7 @@ TString BaseExportManager::GetFilePath(TVirtualPad* pad, const char* filename) c
             if (inFolder_) {
                 // "foo/bar" --> "foo/bar/bar.ext"
                 TString basename = gSystem->BaseName(str);
-                gSystem->mkdir(str); // create directory
+                sink_->MakeDirectory(str); // create directory
                 str.Append("/" + basename);
             }
             str.Append(ext_);
@@ -111,22 +786,28 @@ TString BaseExportManager::GetFilePath(TVirtualPad* pad, const char* filename) c
             else {
                 str.Prepend(str(0, s2) + "/");
             }
-            gSystem->mkdir(gSystem->DirName(str)); // create directory
+            sink_->MakeDirectory(gSystem->DirName(str)); // create directory
         }
         // std::cout << str << std::endl;
     }
     else {
         // no extension --> filename is actually a folder name
-        if (gSystem->AccessPathName(str)) gSystem->mkdir(str); // create folder if it does not exist
+        sink_->MakeDirectory(str); // create folder if it does not exist
     }
 
-    gSystem->ExpandPathName(str);
+    PathResolver::ExpandPath(str);
 
     return str;
 }
 
-/// @brief Save a drawn data object to an external file using ROOTToText
-void BaseExportManager::SaveData(const TObject* obj, PadProperties::Data& data) const {
+/// @brief Get the RTT option and the number of columns of the data file of a drawn object
+/// @param obj data object (drawn in the current pad)
+/// @param data dataset properties
+/// @param draw_option drawing option of the object
+/// @param stack if obj is drawn in a stack, the data saved is the sum of the stack histograms up to obj
+/// @param layer index of obj in the stack
+/// @return RTT option ; number of columns
+std::pair<TString, int> BaseExportManager::GetDataFormat(const TObject* obj, const PadProperties::Data& data, const TString& draw_option, const THStack* stack, int layer) {
     TString option = "";
     int ncol = 0;
     switch (data.type) {
@@ -138,16 +819,7 @@ void BaseExportManager::SaveData(const TObject* obj, PadProperties::Data& data)
                     // TGraphErrors
                     ncol++;
                     // do not save EX if it is an array of 0
-                    auto EX = gr->GetEX();
-                    auto np = gr->GetN();
-                    bool is_empty_EX = true;
-                    for (int i = 0; i < np; i++) {
-                        if (EX[i] > 0) {
-                            is_empty_EX = false;
-                            break;
-                        };
-                    }
-                    if (!is_empty_EX) {
+                    if (!ScanData(gr->GetEX(), gr->GetN()).allZero) {
                         ncol++;
                         option = "H";
                     }
@@ -160,11 +832,19 @@ void BaseExportManager::SaveData(const TObject* obj, PadProperties::Data& data)
             auto h = dynamic_cast<const TH1*>(obj);
             if (h) {
                 ncol = 2;
-                TString opth = h->GetDrawOption();
+                TString opth = draw_option;
                 // opth.Append(h->GetOption());
                 opth.ToUpper();
                 bool with_err = false;
                 if (h->GetSumw2()->GetSize()) with_err = true;           // sum of weight -> error bars
+                if (stack) {
+                    // the sum of the stacked histograms has errors if any of them has
+                    TIter next(stack->GetHists());
+                    for (int i = 0; i <= layer && !with_err; i++) {
+                        auto hi = dynamic_cast<const TH1*>(next());
+                        if (hi && hi->GetSumw2N()) with_err = true;
+                    }
+                }
                 if (with_err && opth.Contains("HIST")) with_err = false; // remove errors if drawn with HIST
                 if (!with_err && opth.Contains("E")) with_err = true;    // ...unless option 'E' is given
                 if (with_err) {
@@ -180,16 +860,44 @@ void BaseExportManager::SaveData(const TObject* obj, PadProperties::Data& data)
             break;
     }
 
-    TString filename = "";
-    if (gRTT->SaveObject(obj, data.type, filename, option)) {
+    return {option, ncol};
+}
+
+/// @brief Check if a dataset is a graph drawn with a line only (no markers, no error bars), that can be reduced
+/// @param ncol number of columns of the data file
+bool BaseExportManager::IsLineOnly(const PadProperties::Data& data, int ncol) {
+    return data.type == Graph1D && ncol == 2 && data.line.style && !data.marker.style;
+}
+
+/// @brief Save a drawn data object to an external file using ROOTToText
+/// @param obj data object
+/// @param data dataset properties (the file name and number of columns are updated, the file name may be preset)
+/// @param format RTT option and number of columns (see GetDataFormat)
+/// @param stack if obj is drawn in a stack, the data saved is the sum of the stack histograms up to obj
+/// @param layer index of obj in the stack
+/// @param columns pixel columns of the plot, for the graphs drawn with a line only (see EnableDecimation)
+/// @return false if the file could not be written
+bool BaseExportManager::SaveData(const TObject* obj, PadProperties::Data& data, const std::pair<TString, int>& format, const THStack* stack, int layer, const PixelColumns* columns) const {
+    TString filename = data.file.first; // base name (default: object name)
+    bool saved = false;
+    if (stack)
+        saved = gRTT->SaveStackLayer(stack, layer, filename, format.first);
+    else if (lod_ && IsLineOnly(data, format.second)) // coarsest level: about 4 points per pixel column
+        saved = gRTT->SaveGraphPyramid(static_cast<const TGraph*>(obj), columns && columns->n > 0 ? 4 * columns->n : 4096, filename, format.first);
+    else if (decimate_ && columns && columns->IsValid() && IsLineOnly(data, format.second))
+        saved = gRTT->SaveDecimatedGraph(static_cast<const TGraph*>(obj), *columns, filename, format.first);
+    else
+        saved = gRTT->SaveObject(obj, data.type, filename, format.first);
+    if (saved) {
         data.file.first = gSystem->BaseName(filename);
-        data.file.second = ncol;
+        data.file.second = format.second;
         if (!dataDir_.IsWhitespace())
             data.file.first.Prepend(dataDir_ + "/");
     }
     else {
         LOG_ERROR("Could not save data " << obj->GetName() << " (" << obj->IsA()->GetName() << ").");
     }
+    return saved;
 }
 
 /// @brief If set, the data files will be saved in a separated folder
@@ -208,11 +916,58 @@ void BaseExportManager::SetVerbose(bool v) {
     verb_ = v;
 }
 
+/// @brief Set the destination of the script and data files (nullptr : files on disk)
+/// @param sink output sink, it is not owned by the export manager
+void BaseExportManager::SetOutputSink(OutputSink* sink) {
+    sink_ = sink ? sink : FileSink::GetInstance();
+}
+
+/// @brief Set to true to write only the points needed to draw the graph lines at the resolution of the pad
+///
+/// For the graphs drawn with a line and without markers or error bars, the first, last, lowest and highest points
+/// of each pixel column of the frame are kept (M4 decimation): the plot looks the same at the size of the pad,
+/// and the scripts of graphs with millions of points are rendered quickly. The number of points kept is written
+/// in the header of the data files.
+void BaseExportManager::EnableDecimation(bool flag) {
+    decimate_ = flag;
+}
+
+/// @brief Set to true to save the plot properties in a binary snapshot (*.rexp) next to each script
+void BaseExportManager::EnableSnapshot(bool flag) {
+    snapshot_ = flag;
+}
+
 /// @brief Set to true to ignore functions associated with histograms (e.g. from fits)
 void BaseExportManager::IgnoreListOfFunctions(bool flag) {
     saveListFunc_ = !flag;
 }
 
+/// @brief Save a data object which is not drawn in a pad, with the settings of this manager (sink, comment char, ...)
+///
+/// It can be called from several threads, and concurrently with ExportPad.
+/// @param obj data object
+/// @param filename path of the data file, without extension (e.g. "out/dir/h1")
+/// @param opt RTT option
+/// @return false if the file could not be written
+bool DataExportManager::SaveObject(const TObject* obj, const char* filename, Option_t* opt) const {
+    TString folder = gSystem->DirName(filename);
+    if (!sink_->IsWritable(folder)) {
+        LOG_ERROR("Cannot write to directory " << folder);
+        return false;
+    }
+    TString name = gSystem->BaseName(filename);
+
+    std::lock_guard<std::mutex> lock(rttMutex);
+    RTTSettingsGuard rtt_settings; // restored also if the object cannot be saved
+    gRTT->SetOutputSink(sink_);
+    gRTT->SetDirectory(folder);
+    gRTT->SetCommentChar(com_);
+    gRTT->SetVerbose(verb_);
+    bool saved = gRTT->SaveObject(obj, name, opt);
+    if (!saved) LOG_ERROR("Could not save data " << obj->GetName() << " (" << obj->IsA()->GetName() << ").");
+    return saved;
+}
+
 VirtualExportManager::VirtualExportManager() : BaseExportManager() {
     EnableLatex();
 }
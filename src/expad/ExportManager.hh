@@ -1,12 +1,37 @@
 #ifndef EXPORTMANAGER_HH
 #define EXPORTMANAGER_HH
 
+#include "Decimation.hh"
+#include "Fingerprint.hh"
+#include "OutputSink.hh"
 #include "PadProperties.hh"
 
+#include <functional>
+#include <future>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class THStack;
 class TVirtualPad;
 
 namespace REx {
 
+class PlotBuilder;
+class PlotSerializer;
+struct ExportJob;
+
+/// @brief Result of the export of one plot (see BaseExportManager::ExportPads)
+struct ExportResult {
+    TString pad;               // pad name
+    TString filename;          // script path
+    bool ok = false;           // all the files were written
+    TString error;             // exception message, if any
+    double serializeTime = 0;  // serialization and copy of the data objects (ms)
+    double dataTime = 0;       // data files (ms)
+    double scriptTime = 0;     // script (ms)
+};
+
 /// @brief Base class for exporting plots
 class BaseExportManager {
 public:
@@ -14,15 +39,41 @@ public:
     virtual ~BaseExportManager();
 
     void ExportPad(TVirtualPad* pad, const char* filename) const;
+    static bool ExportPad(TVirtualPad* pad, const char* filename, const std::vector<const BaseExportManager*>& managers);
+    bool ExportPlot(const PlotBuilder& plot, const char* filename = "") const;
+    static bool ExportPlot(const PlotBuilder& plot, const char* filename, const std::vector<const BaseExportManager*>& managers);
+    std::future<bool> ExportPadAsync(TVirtualPad* pad, const char* filename) const;
+    static void WaitForExports();
+    std::vector<ExportResult> ExportPads(const std::vector<TVirtualPad*>& pads, const std::vector<TString>& filenames = {}, size_t queue_size = 4) const;
+    bool ExportSnapshot(const char* snapshot, const char* filename = "") const;
+    void EnableSnapshot(bool flag = true);
+    void EnableDecimation(bool flag = true);
     void SetDataDirectory(TString folder_name);
     void SaveInFolder(bool flag);
     void SetVerbose(bool v);
     void IgnoreListOfFunctions(bool flag);
+    void SetOutputSink(OutputSink* sink);
 
 protected:
-    TString GetFilePath(TVirtualPad* pad, const char* filename) const;
-    virtual void SaveData(const TObject* obj, PadProperties::Data& data) const;
-    virtual void WriteToFile(const char* filename, const PadProperties& pp) const = 0;
+    TString GetFilePath(const char* name, const char* filename) const;
+    bool GetDataFolder(const TString& path, TString& folder) const;
+    static std::vector<std::vector<const BaseExportManager*>> SplitBySaveFunctions(const std::vector<const BaseExportManager*>& managers);
+    static std::unique_ptr<ExportJob> PrepareExport(TVirtualPad* pad, const char* filename, const std::vector<const BaseExportManager*>& managers, const FingerprintCache* fingerprints = nullptr);
+    static std::unique_ptr<ExportJob> PrepareExport(std::unique_ptr<PlotSerializer> serializer, const char* filename, const std::vector<const BaseExportManager*>& managers);
+    static bool RunExport(ExportJob& job);
+    static bool WriteDataFiles(ExportJob& job);
+    static std::vector<bool> PrepareUpdate(ExportJob& job, const FingerprintCache* fingerprints = nullptr);
+    static std::unique_ptr<ExportJob> CopyExport(const ExportJob& job, const std::vector<bool>& keep, bool clone_data);
+    static bool WriteUpdate(ExportJob& job, const std::vector<bool>& keep);
+    static bool WriteScripts(ExportJob& job);
+    static void SetDataFormats(ExportJob& job);
+    static void GetAllPads(PlotSerializer& ps, PadProperties& pp, std::vector<std::pair<PlotSerializer*, PadProperties*>>& pads);
+    bool SaveAllData(PlotSerializer& ps, PadProperties& pp, const TString& folder, const std::vector<std::vector<std::pair<TString, int>>>& formats, const std::vector<bool>* keep = nullptr) const;
+    bool WriteSnapshot(const TString& path, const PadProperties& pp) const;
+    static std::pair<TString, int> GetDataFormat(const TObject* obj, const PadProperties::Data& data, const TString& draw_option, const THStack* stack = nullptr, int layer = -1);
+    static bool IsLineOnly(const PadProperties::Data& data, int ncol);
+    virtual bool SaveData(const TObject* obj, PadProperties::Data& data, const std::pair<TString, int>& format, const THStack* stack = nullptr, int layer = -1, const PixelColumns* columns = nullptr) const;
+    virtual bool WriteToFile(const char* filename, const PadProperties& pp) const = 0;
 
 protected:
     TString ext_;
@@ -31,6 +82,51 @@ protected:
     bool inFolder_;
     bool verb_; // verbose
     bool saveListFunc_;
+    bool snapshot_;       // save the plot properties next to the script (see ExportSnapshot)
+    bool decimate_;       // write only the points of the graph lines drawn at the resolution of the pad (see EnableDecimation)
+    bool lod_;            // write the graph lines as level-of-detail pyramids (see PyplotExportManager::EnableLevelOfDetail)
+    TString contentType_; // content type of the script
+    OutputSink* sink_;    // destination of the files (not owned)
+
+    friend class IncrementalExport;
+};
+
+/// @brief Export of a pad repeated over time (e.g. a live canvas), writing only the data files that changed
+///
+/// The pad is serialized again incrementally (see PlotSerializer::Update): the unmodified objects are not extracted
+/// again, and the data files of the datasets with the same data and format are kept. The scripts are always written.
+/// The pad and the export managers must stay alive while the export is used.
+///
+/// Usage:
+///     REx::IncrementalExport live(c1, "output/live", {&rex_gnuplot, &rex_python});
+///     while (running) {
+///         // ... fill the histograms ...
+///         live.Export();
+///     }
+class IncrementalExport {
+public:
+    IncrementalExport(TVirtualPad* pad, const char* filename, const std::vector<const BaseExportManager*>& managers);
+    ~IncrementalExport();
+
+    bool Export();
+    void Reset();
+    inline TVirtualPad* GetPad() const { return pad_; };
+    inline int GetNumberOfDatasetsWritten() const { return nwritten_; };
+
+private:
+    std::unique_ptr<ExportJob> Prepare(bool clone_data, const FingerprintCache* fingerprints = nullptr);
+    bool Write(ExportJob& copy);
+    std::function<bool()> PrepareAsync(const FingerprintCache* fingerprints = nullptr);
+
+private:
+    TVirtualPad* pad_;
+    TString filename_;
+    std::vector<const BaseExportManager*> managers_;
+    std::unique_ptr<ExportJob> job_; //! last export (serialized plot and data file names)
+    std::vector<bool> keep_;         // datasets of the main pad whose data file is kept by the current export
+    int nwritten_;                   // datasets whose data files were written by the last export
+
+    friend class WatchService;
 };
 
 /// @brief Export all data objects drawn in a plot to text files
@@ -39,8 +135,10 @@ public:
     DataExportManager() {};
     virtual ~DataExportManager() {};
 
+    bool SaveObject(const TObject* obj, const char* filename, Option_t* opt = "") const;
+
 protected:
-    void WriteToFile(const char*, const PadProperties&) const override {};
+    bool WriteToFile(const char*, const PadProperties&) const override { return true; };
 };
 
 /// @brief Base virtual class for exporting plots to external tools as text files (script + data)
@@ -54,7 +152,7 @@ public:
 protected:
     virtual TString FormatLabel(const TString& str, bool escape = true) const;
 
-    virtual void WriteToFile(const char*, const PadProperties&) const = 0;
+    virtual bool WriteToFile(const char*, const PadProperties&) const = 0;
 
     virtual void SetTitleAndAxis(std::ofstream& ofs, const PadProperties& pp) const = 0;
     virtual void SetData(std::ofstream& ofs, const PadProperties& pp) const = 0;
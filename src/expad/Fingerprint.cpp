@@ -0,0 +1,228 @@
+#include "Fingerprint.hh"
+
+#include "TArrayD.h"
+#include "TAttFill.h"
+#include "TAttLine.h"
+#include "TAttMarker.h"
+#include "TAttText.h"
+#include "TAxis.h"
+#include "TF1.h"
+#include "TGraph.h"
+#include "TH1.h"
+#include "THStack.h"
+#include "TLegend.h"
+#include "TLegendEntry.h"
+#include "TLine.h"
+#include "TList.h"
+#include "TMultiGraph.h"
+#include "TText.h"
+#include "TVirtualPad.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace REx {
+
+namespace {
+
+/// @brief 64-bit hash, fed with words rather than bytes (the data arrays can be large)
+class Hasher {
+public:
+    void Add(uint64_t w) {
+        h_ ^= w;
+        h_ *= 0x100000001b3ULL; // FNV prime
+        h_ ^= h_ >> 29;
+    }
+    void Add(double x) {
+        uint64_t w;
+        std::memcpy(&w, &x, sizeof(w));
+        Add(w);
+    }
+    void Add(const void* p) { Add(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p))); }
+    void Add(const char* str) {
+        size_t n = str ? strlen(str) : 0;
+        Add(static_cast<uint64_t>(n));
+        for (size_t i = 0; i < n; i += 8) {
+            uint64_t w = 0;
+            std::memcpy(&w, str + i, std::min<size_t>(8, n - i));
+            Add(w);
+        }
+    }
+    void Add(const double* x, int n) {
+        Add(static_cast<uint64_t>(x ? n : -1));
+        if (!x) return;
+        for (int i = 0; i < n; i++)
+            Add(x[i]);
+    }
+    uint64_t Get() const { return h_; }
+
+private:
+    uint64_t h_ = 0xcbf29ce484222325ULL; // FNV offset basis
+};
+
+void AddStyle(Hasher& hs, const TObject* obj) {
+    hs.Add(obj->GetName());
+    hs.Add(obj->GetTitle());
+    if (auto line = dynamic_cast<const TAttLine*>(obj)) {
+        hs.Add(static_cast<uint64_t>(line->GetLineColor()));
+        hs.Add(static_cast<uint64_t>(line->GetLineStyle()));
+        hs.Add(static_cast<uint64_t>(line->GetLineWidth()));
+    }
+    if (auto marker = dynamic_cast<const TAttMarker*>(obj)) {
+        hs.Add(static_cast<uint64_t>(marker->GetMarkerColor()));
+        hs.Add(static_cast<uint64_t>(marker->GetMarkerStyle()));
+        hs.Add(static_cast<double>(marker->GetMarkerSize()));
+    }
+    if (auto fill = dynamic_cast<const TAttFill*>(obj)) {
+        hs.Add(static_cast<uint64_t>(fill->GetFillColor()));
+        hs.Add(static_cast<uint64_t>(fill->GetFillStyle()));
+    }
+    if (auto text = dynamic_cast<const TAttText*>(obj)) {
+        hs.Add(static_cast<uint64_t>(text->GetTextColor()));
+        hs.Add(static_cast<uint64_t>(text->GetTextAlign()));
+        hs.Add(static_cast<double>(text->GetTextSize()));
+    }
+}
+
+void AddAxis(Hasher& hc, const TAxis* ax) {
+    hc.Add(static_cast<uint64_t>(ax->GetNbins()));
+    hc.Add(ax->GetXmin());
+    hc.Add(ax->GetXmax());
+    hc.Add(static_cast<uint64_t>(ax->GetFirst()));
+    hc.Add(static_cast<uint64_t>(ax->GetLast()));
+    const TArrayD* bins = ax->GetXbins();
+    if (bins && bins->GetSize()) hc.Add(bins->GetArray(), bins->GetSize());
+}
+
+/// @brief Add the children of a stack or a multigraph (address, option, style and content)
+void AddList(Hasher& hs, Hasher& hc, const TList* list) {
+    if (!list) return;
+    TListIter next(list);
+    while (const TObject* obj = next()) {
+        Fingerprint fp = Fingerprint::Compute(obj, next.GetOption());
+        hc.Add(obj);
+        hc.Add(fp.content);
+        hs.Add(fp.style);
+    }
+}
+
+} // namespace
+
+/// @brief Compute the fingerprint of an object drawn in a pad
+/// @param obj data object, legend, text...
+/// @param option drawing option (it changes the format of the data files)
+Fingerprint Fingerprint::Compute(const TObject* obj, Option_t* option) {
+    Fingerprint fp;
+    fp.obj = obj;
+    if (!obj) return fp;
+    fp.uid = obj->GetUniqueID();
+
+    Hasher hs, hc;
+    AddStyle(hs, obj);
+    hc.Add(option);
+    hc.Add(obj->GetOption());
+    if (auto h = dynamic_cast<const TH1*>(obj)) {
+        const int ncells = h->GetNcells();
+        if (auto arr = dynamic_cast<const TArrayD*>(h))
+            hc.Add(arr->GetArray(), arr->GetSize());
+        else
+            for (int i = 0; i < ncells; i++)
+                hc.Add(h->RetrieveBinContent(i));
+        if (h->GetSumw2N()) hc.Add(h->GetSumw2()->GetArray(), h->GetSumw2N());
+        AddAxis(hc, h->GetXaxis());
+        hc.Add(h->GetMinimumStored());
+        hc.Add(h->GetMaximumStored());
+        TListIter next(h->GetListOfFunctions());
+        while (const TObject* func = next()) {
+            Fingerprint ff = Compute(func, "");
+            hc.Add(func);
+            hc.Add(static_cast<uint64_t>(func->TestBit(TF1::kNotDraw)));
+            hc.Add(ff.content);
+            hs.Add(ff.style);
+        }
+    }
+    else if (auto gr = dynamic_cast<const TGraph*>(obj)) {
+        const int n = gr->GetN();
+        hc.Add(gr->GetX(), n);
+        hc.Add(gr->GetY(), n);
+        hc.Add(gr->GetEXlow(), n);
+        hc.Add(gr->GetEXhigh(), n);
+        hc.Add(gr->GetEYlow(), n);
+        hc.Add(gr->GetEYhigh(), n);
+        hc.Add(gr->GetMinimum());
+        hc.Add(gr->GetMaximum());
+    }
+    else if (auto f = dynamic_cast<const TF1*>(obj)) {
+        double xmin, xmax;
+        f->GetRange(xmin, xmax);
+        hc.Add(xmin);
+        hc.Add(xmax);
+        hc.Add(static_cast<uint64_t>(f->GetNpx()));
+        hc.Add(f->GetExpFormula().Data());
+        hc.Add(f->GetParams(), f->GetNpar());
+    }
+    else if (auto hst = dynamic_cast<const THStack*>(obj)) {
+        AddList(hs, hc, hst->GetHists());
+    }
+    else if (auto mg = dynamic_cast<const TMultiGraph*>(obj)) {
+        AddList(hs, hc, mg->GetListOfGraphs());
+    }
+    else if (auto leg = dynamic_cast<const TLegend*>(obj)) {
+        hc.Add(leg->GetX1NDC());
+        hc.Add(leg->GetY1NDC());
+        hc.Add(leg->GetX2NDC());
+        hc.Add(leg->GetY2NDC());
+        for (const auto* item : *leg->GetListOfPrimitives()) {
+            auto entry = static_cast<const TLegendEntry*>(item);
+            hc.Add(entry->GetObject());
+            hc.Add(entry->GetLabel());
+            hc.Add(entry->GetOption());
+        }
+    }
+    else if (auto text = dynamic_cast<const TText*>(obj)) {
+        hc.Add(text->GetX());
+        hc.Add(text->GetY());
+    }
+    else if (auto line = dynamic_cast<const TLine*>(obj)) {
+        hc.Add(line->GetX1());
+        hc.Add(line->GetY1());
+        hc.Add(line->GetX2());
+        hc.Add(line->GetY2());
+    }
+    fp.style = hs.Get();
+    fp.content = hc.Get();
+    return fp;
+}
+
+bool operator==(const Fingerprint& lf, const Fingerprint& rf) {
+    return lf.SameObject(rf) && lf.style == rf.style && lf.content == rf.content;
+}
+
+bool operator!=(const Fingerprint& lf, const Fingerprint& rf) {
+    return !(lf == rf);
+}
+
+/// @brief Hash of all the objects drawn in a pad and in its subpads (fingerprints of the objects, in drawing order)
+/// @param fingerprints if given, filled with the fingerprints of the objects (reused by PlotSerializer::Update)
+uint64_t ComputePadHash(const TVirtualPad* pad, FingerprintCache* fingerprints) {
+    Hasher hp;
+    if (!pad) return hp.Get();
+    hp.Add(pad->GetName());
+    TListIter next(pad->GetListOfPrimitives());
+    while (const TObject* obj = next()) {
+        if (auto sub = dynamic_cast<const TVirtualPad*>(obj)) {
+            hp.Add(ComputePadHash(sub, fingerprints));
+            continue;
+        }
+        Option_t* option = next.GetOption();
+        Fingerprint fp = Fingerprint::Compute(obj, option);
+        if (fingerprints) (*fingerprints)[{obj, option ? option : ""}] = fp;
+        hp.Add(obj);
+        hp.Add(static_cast<uint64_t>(fp.uid));
+        hp.Add(fp.style);
+        hp.Add(fp.content);
+    }
+    return hp.Get();
+}
+
+} // namespace REx
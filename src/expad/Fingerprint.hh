@@ -0,0 +1,41 @@
+#ifndef FINGERPRINT_HH
+#define FINGERPRINT_HH
+
+#include "Rtypes.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+
+class TObject;
+class TVirtualPad;
+
+namespace REx {
+
+/// @brief Summary of the state of an object drawn in a pad, to detect its changes between two serializations
+///
+/// The style hash covers what changes the plot properties only (title, line/marker/fill attributes), the content hash
+/// covers what changes the data files (values, binning, drawing option, components of stacks and multigraphs).
+/// Two fingerprints of the same object can only be equal if the object was not modified, up to hash collisions.
+struct Fingerprint {
+    const TObject* obj = nullptr;
+    UInt_t uid = 0;        // TObject unique ID (changes if the object is replaced at the same address)
+    uint64_t style = 0;
+    uint64_t content = 0;
+
+    static Fingerprint Compute(const TObject* obj, Option_t* option);
+    inline bool SameObject(const Fingerprint& fp) const { return obj == fp.obj && uid == fp.uid; };
+};
+
+bool operator==(const Fingerprint& lf, const Fingerprint& rf);
+bool operator!=(const Fingerprint& lf, const Fingerprint& rf);
+
+/// @brief Fingerprints of the primitives of a pad, by object and drawing option (see ComputePadHash)
+using FingerprintCache = std::map<std::pair<const TObject*, std::string>, Fingerprint>;
+
+uint64_t ComputePadHash(const TVirtualPad* pad, FingerprintCache* fingerprints = nullptr);
+
+} // namespace REx
+
+#endif
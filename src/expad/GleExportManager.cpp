@@ -11,6 +11,9 @@
 #include <unordered_map>
 
 namespace {
+const double kPageWidth = 10; // cm
+const double kPageHeight = 7; // cm
+
 const std::unordered_map<int, std::string> GLE_marker = {
     {1, "dot"},
     {2, "plus"},
@@ -66,26 +69,43 @@ namespace REx {
 GleExportManager::GleExportManager() {
     ext_ = ".gle";
     com_ = '!';
+    contentType_ = "text/x-gle";
 }
 
 GleExportManager::~GleExportManager() {
 }
 
-void GleExportManager::WriteToFile(const char* filename, const PadProperties& pp) const {
-    std::ofstream ofs(filename);
-    if (!ofs.is_open()) {
+bool GleExportManager::WriteToFile(const char* filename, const PadProperties& pp) const {
+    std::ofstream ofs;
+    if (!sink_->Open(filename, ofs)) {
         LOG_ERROR("Could not open file " << filename);
-        return;
+        return false;
     }
 
     // write default header (gle configuration : size, font, etc...)
     InitFile(ofs);
 
+    if (pp.subpads.empty())
+        SetPad(ofs, pp);
+    else
+        SetSubpads(ofs, pp); // divided canvas : one graph per subpad
+
+    if (!sink_->Close(filename, ofs, contentType_)) {
+        LOG_ERROR("Could not write file " << filename);
+        return false;
+    }
+    return true;
+}
+
+/// @brief Write the graph of one pad (subpads: with the size of the pad)
+void GleExportManager::SetPad(std::ofstream& ofs, const PadProperties& pp) const {
     // >>> plot data
 
     // start graph
-    ofs << "begin graph\n"
-        << "\tscale auto\n"
+    ofs << "begin graph\n";
+    if (pp.position.isok)
+        ofs << "\tsize " << kPageWidth * (pp.position.x2 - pp.position.x1) << " " << kPageHeight * (pp.position.y2 - pp.position.y1) << "\n";
+    ofs << "\tscale auto\n"
         << std::endl;
 
     SetTitleAndAxis(ofs, pp);
@@ -103,12 +123,22 @@ void GleExportManager::WriteToFile(const char* filename, const PadProperties& pp
 
     // plot other graphical elements
     SetDecorators(ofs, pp);
+}
 
-    ofs.close();
+/// @brief Write the graphs of the subpads, each one moved to the position of its subpad
+void GleExportManager::SetSubpads(std::ofstream& ofs, const PadProperties& pp) const {
+    for (const auto& sub : pp.subpads) {
+        if (sub.datasets.size()) {
+            ofs << "\n! subpad " << sub.name << "\n"
+                << "amove " << kPageWidth * sub.position.x1 << " " << kPageHeight * sub.position.y1 << std::endl;
+            SetPad(ofs, sub);
+        }
+        SetSubpads(ofs, sub);
+    }
 }
 
 void GleExportManager::InitFile(std::ofstream& ofs) const {
-    ofs << "size 10 7\n"
+    ofs << "size " << kPageWidth << " " << kPageHeight << "\n"
         << "set hei 0.353\n"
         << "set lwidth 0.015\n"
         << "set texlabels 1\n"
@@ -144,20 +174,20 @@ void GleExportManager::SetData(std::ofstream& ofs, const PadProperties& pp) cons
     int n = pp.datasets.size();
     int idx_data = 1;
     for (int i = 0; i < n; i++) {
-        const auto di = pp.datasets[i];
+        const auto& di = pp.datasets[i];
         // read data file
         ofs << "\n\tdata \"" << di.file.first << "\"" << std::endl;
 
         // marker, line & color
         ofs << "\td" << idx_data;
         auto ci = Black;
-        auto mi = di.marker;
+        const auto& mi = di.marker;
         if (mi.style) {
             ofs << " marker " << (GLE_marker.count(mi.style) ? GLE_marker.at(mi.style) : "circle");
             ofs << " msize " << 0.02 * mi.size; // 0.2 / 10
             ci = mi.color;
         }
-        auto li = di.line;
+        const auto& li = di.line;
         if (li.style) {
             if (di.type == Histo1D)
                 ofs << " line hist";
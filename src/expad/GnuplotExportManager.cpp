@@ -69,6 +69,7 @@ namespace REx {
 GnuplotExportManager::GnuplotExportManager() {
     ext_ = ".gp";
     com_ = '#';
+    contentType_ = "text/x-gnuplot";
 }
 
 GnuplotExportManager::~GnuplotExportManager() {
@@ -90,11 +91,11 @@ TString GnuplotExportManager::FormatLabel(const TString& str) const {
     return ltx;
 }
 
-void GnuplotExportManager::WriteToFile(const char* filename, const PadProperties& pp) const {
-    std::ofstream ofs(filename);
-    if (!ofs.is_open()) {
+bool GnuplotExportManager::WriteToFile(const char* filename, const PadProperties& pp) const {
+    std::ofstream ofs;
+    if (!sink_->Open(filename, ofs)) {
         LOG_ERROR("Could not open file " << filename);
-        return;
+        return false;
     }
 
     TString outfile(gSystem->BaseName(filename));    // outfile : *.gp
@@ -103,6 +104,28 @@ void GnuplotExportManager::WriteToFile(const char* filename, const PadProperties
     // write default header (gnuplot configuration)
     InitFile(ofs, outfile);
 
+    if (pp.subpads.empty())
+        SetPad(ofs, pp);
+    else {
+        // divided canvas : one plot per subpad
+        ofs << "\nset multiplot" << std::endl;
+        SetSubpads(ofs, pp);
+        ofs << "\nunset multiplot" << std::endl;
+    }
+
+    ofs << "\nunset output"
+        << "\n!pdflatex -interaction=nonstopmode " << outfile
+        << std::endl;
+
+    if (!sink_->Close(filename, ofs, contentType_)) {
+        LOG_ERROR("Could not write file " << filename);
+        return false;
+    }
+    return true;
+}
+
+/// @brief Plot the content of one pad
+void GnuplotExportManager::SetPad(std::ofstream& ofs, const PadProperties& pp) const {
     // >>> plot data
     SetTitleAndAxis(ofs, pp);
 
@@ -116,12 +139,23 @@ void GnuplotExportManager::WriteToFile(const char* filename, const PadProperties
     SetData(ofs, pp);
 
     // plot data <<<
+}
 
-    ofs << "\nunset output"
-        << "\n!pdflatex -interaction=nonstopmode " << outfile
-        << std::endl;
-
-    ofs.close();
+/// @brief Plot the subpads (multiplot), the frame of each plot is placed at the position of its subpad frame
+void GnuplotExportManager::SetSubpads(std::ofstream& ofs, const PadProperties& pp) const {
+    for (const auto& sub : pp.subpads) {
+        if (sub.datasets.size()) {
+            const auto& f = sub.frame;
+            ofs << "\n# subpad " << sub.name << "\n"
+                << "reset\n" // labels, arrows and axis settings of the previous subpad
+                << "set lmargin at screen " << f.x1 << "\n"
+                << "set rmargin at screen " << f.x2 << "\n"
+                << "set bmargin at screen " << f.y1 << "\n"
+                << "set tmargin at screen " << f.y2 << std::endl;
+            SetPad(ofs, sub);
+        }
+        SetSubpads(ofs, sub);
+    }
 }
 
 void GnuplotExportManager::InitFile(std::ofstream& ofs, const TString& file) const {
@@ -172,11 +206,11 @@ void GnuplotExportManager::SetData(std::ofstream& ofs, const PadProperties& pp)
     int n = pp.datasets.size();
     ofs << "\nplot ";
     for (int i = 0; i < n; ++i) {
-        auto di = pp.datasets[i];
+        const auto& di = pp.datasets[i];
         ofs << " \"" << di.file.first << "\"";
         auto ci = Black;     // color
-        auto mi = di.marker; // marker
-        auto li = di.line;   // line
+        const auto& mi = di.marker; // marker
+        const auto& li = di.line;   // line
         // pointtype style
         if (mi.style) {
             ofs << " ps " << 0.05 * mi.size;
@@ -14,7 +14,7 @@ public:
     virtual ~GnuplotExportManager();
 
 protected:
-    virtual void WriteToFile(const char* filename, const PadProperties& pp) const;
+    virtual bool WriteToFile(const char* filename, const PadProperties& pp) const;
     virtual void SetTitleAndAxis(std::ofstream& ofs, const PadProperties& pp) const;
     virtual void SetData(std::ofstream& ofs, const PadProperties& pp) const;
     virtual void SetLegend(std::ofstream& ofs, const PadProperties& pp) const;
@@ -24,6 +24,8 @@ protected:
 
 private:
     void InitFile(std::ofstream& ofs, const TString& file) const;
+    void SetPad(std::ofstream& ofs, const PadProperties& pp) const;
+    void SetSubpads(std::ofstream& ofs, const PadProperties& pp) const;
 };
 } // namespace REx
 
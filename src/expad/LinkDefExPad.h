@@ -5,9 +5,16 @@
 #include "LinkDefBase.h" // creation of base dictionaries for REx
 
 // Turn on creation of additional dictionaries for REx/ExPad module
+#pragma link C++ struct REx::ExportResult+;
+#pragma link C++ class std::vector<REx::ExportResult>+;
 #pragma link C++ class REx::BaseExportManager;
 #pragma link C++ class REx::VirtualExportManager;
 #pragma link C++ class REx::DataExportManager;
+#pragma link C++ class REx::PlotBuilder;
+#pragma link C++ class REx::IncrementalExport;
+#pragma link C++ struct REx::WatchStats+;
+#pragma link C++ class std::vector<REx::WatchStats>+;
+#pragma link C++ class REx::WatchService;
 #pragma link C++ class REx::GleExportManager;
 #pragma link C++ class REx::GnuplotExportManager;
 #pragma link C++ class REx::PyplotExportManager;
@@ -1,4 +1,122 @@
 #include "PadProperties.hh"
+#include "Log.hh"
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+namespace {
+
+// Snapshot format: "REXP", version (uint16), then the fields (version 1 fields first, then subpads recursively).
+// Integers and doubles are stored in little endian, strings as length (uint32) + characters.
+const char kSnapshotMagic[4] = {'R', 'E', 'X', 'P'};
+const int kMaxSnapshotDepth = 16; // subpads in subpads
+
+void WriteUInt(std::ostream& os, uint64_t v, int nbytes) {
+    char buf[8];
+    for (int i = 0; i < nbytes; i++)
+        buf[i] = (char)((v >> (8 * i)) & 0xFF);
+    os.write(buf, nbytes);
+}
+
+uint64_t ReadUInt(std::istream& is, int nbytes) {
+    unsigned char buf[8] = {0};
+    is.read((char*)buf, nbytes);
+    uint64_t v = 0;
+    for (int i = 0; i < nbytes; i++)
+        v |= (uint64_t)buf[i] << (8 * i);
+    return v;
+}
+
+void WriteDouble(std::ostream& os, double d) {
+    uint64_t v;
+    memcpy(&v, &d, sizeof(v));
+    WriteUInt(os, v, 8);
+}
+
+double ReadDouble(std::istream& is) {
+    uint64_t v = ReadUInt(is, 8);
+    double d;
+    memcpy(&d, &v, sizeof(d));
+    return d;
+}
+
+void WriteString(std::ostream& os, const TString& str) {
+    WriteUInt(os, str.Length(), 4);
+    os.write(str.Data(), str.Length());
+}
+
+void ReadString(std::istream& is, TString& str) {
+    uint32_t n = ReadUInt(is, 4);
+    if (!is || n > (1u << 24)) { // corrupted length : do not allocate it
+        is.setstate(std::ios_base::failbit);
+        return;
+    }
+    std::string buf(n, '\0');
+    if (n) is.read(&buf[0], n);
+    str = TString(buf.data(), n);
+}
+
+void WriteColor(std::ostream& os, const REx::PadProperties::Color& c) {
+    WriteDouble(os, c.red);
+    WriteDouble(os, c.green);
+    WriteDouble(os, c.blue);
+    WriteDouble(os, c.alpha);
+}
+
+void ReadColor(std::istream& is, REx::PadProperties::Color& c) {
+    c.red = ReadDouble(is);
+    c.green = ReadDouble(is);
+    c.blue = ReadDouble(is);
+    c.alpha = ReadDouble(is);
+}
+
+void WriteStyle(std::ostream& os, const REx::PadProperties::DrawingStyle& s) {
+    WriteUInt(os, s.style, 2);
+    WriteUInt(os, s.size, 2);
+    WriteColor(os, s.color);
+}
+
+void ReadStyle(std::istream& is, REx::PadProperties::DrawingStyle& s) {
+    s.style = ReadUInt(is, 2);
+    s.size = ReadUInt(is, 2);
+    ReadColor(is, s.color);
+}
+
+void WriteAxis(std::ostream& os, const REx::PadProperties::AxisProperties& a) {
+    WriteString(os, a.title);
+    WriteUInt(os, a.log, 1);
+    WriteDouble(os, a.min);
+    WriteDouble(os, a.max);
+    WriteColor(os, a.color);
+}
+
+void WriteCoord(std::ostream& os, const REx::PadProperties::Coord& c) {
+    WriteUInt(os, c.isok, 1);
+    WriteDouble(os, c.x1);
+    WriteDouble(os, c.x2);
+    WriteDouble(os, c.y1);
+    WriteDouble(os, c.y2);
+}
+
+void ReadCoord(std::istream& is, REx::PadProperties::Coord& c) {
+    c.isok = ReadUInt(is, 1);
+    c.x1 = ReadDouble(is);
+    c.x2 = ReadDouble(is);
+    c.y1 = ReadDouble(is);
+    c.y2 = ReadDouble(is);
+}
+
+void ReadAxis(std::istream& is, REx::PadProperties::AxisProperties& a) {
+    ReadString(is, a.title);
+    a.log = ReadUInt(is, 1);
+    a.min = ReadDouble(is);
+    a.max = ReadDouble(is);
+    ReadColor(is, a.color);
+}
+
+} // namespace
 
 namespace REx {
 PadProperties::Color::Color(double r, double g, double b, double a) : red(r), green(g), blue(b), alpha(a) {};
@@ -47,14 +165,6 @@ PadProperties::Data::Data() : label(), marker(), line(), file() {
     type = Undefined;
 }
 
-PadProperties::Data::Data(const Data& d) {
-    file = d.file;
-    label = d.label;
-    line = d.line;
-    marker = d.marker;
-    type = d.type;
-}
-
 PadProperties::Decorator::Decorator() : properties(), label(), pos() {
     type = Undefined;
 }
@@ -67,4 +177,115 @@ void PadProperties::Coord::set(double x, double y, double xmax, double ymax) {
     isok = true;
 }
 
+/// @brief Write the plot properties in a compact binary format (see ReadSnapshot)
+void PadProperties::WriteSnapshot(std::ostream& os) const {
+    os.write(kSnapshotMagic, 4);
+    WriteUInt(os, kSnapshotVersion, 2);
+    WriteSnapshotContent(os);
+}
+
+void PadProperties::WriteSnapshotContent(std::ostream& os) const {
+    // version 1
+    WriteString(os, title);
+    WriteAxis(os, xaxis);
+    WriteAxis(os, yaxis);
+    WriteUInt(os, legend, 2);
+
+    WriteUInt(os, datasets.size(), 4);
+    for (const auto& d : datasets) {
+        WriteUInt(os, (uint32_t)d.type, 4);
+        WriteString(os, d.label);
+        WriteStyle(os, d.marker);
+        WriteStyle(os, d.line);
+        WriteString(os, d.file.first);
+        WriteUInt(os, (uint32_t)d.file.second, 4);
+    }
+
+    WriteUInt(os, decorators.size(), 4);
+    for (const auto& d : decorators) {
+        WriteUInt(os, (uint32_t)d.type, 4);
+        WriteStyle(os, d.properties);
+        WriteString(os, d.label);
+        WriteCoord(os, d.pos);
+    }
+
+    // version 2 : subpads
+    WriteString(os, name);
+    WriteCoord(os, position);
+    WriteCoord(os, frame);
+    WriteUInt(os, subpads.size(), 4);
+    for (const auto& sub : subpads)
+        sub.WriteSnapshotContent(os);
+}
+
+/// @brief Read plot properties written by WriteSnapshot
+/// @return false if the stream is not a snapshot, if its version is not supported, or if it is truncated
+bool PadProperties::ReadSnapshot(std::istream& is) {
+    char magic[4] = {0};
+    is.read(magic, 4);
+    if (!is || memcmp(magic, kSnapshotMagic, 4)) {
+        LOG_ERROR("Not a PadProperties snapshot");
+        return false;
+    }
+    unsigned short version = ReadUInt(is, 2);
+    if (!is || version == 0 || version > kSnapshotVersion) {
+        LOG_ERROR("Unsupported snapshot version " << version << " (current version: " << kSnapshotVersion << ")");
+        return false;
+    }
+
+    PadProperties pp;
+    pp.ReadSnapshotContent(is, version, 0);
+    if (!is) {
+        LOG_ERROR("Truncated snapshot");
+        return false;
+    }
+    *this = std::move(pp);
+    return true;
+}
+
+/// @brief Read the properties of a pad and its subpads (the stream state is checked by the caller)
+void PadProperties::ReadSnapshotContent(std::istream& is, unsigned short version, int depth) {
+    // the stream state is checked in the loops : a truncated snapshot stops the reading
+    ReadString(is, title);
+    ReadAxis(is, xaxis);
+    ReadAxis(is, yaxis);
+    legend = ReadUInt(is, 2);
+
+    uint32_t n = ReadUInt(is, 4);
+    for (uint32_t i = 0; i < n && is; i++) {
+        Data d;
+        d.type = (DataType)ReadUInt(is, 4);
+        ReadString(is, d.label);
+        ReadStyle(is, d.marker);
+        ReadStyle(is, d.line);
+        ReadString(is, d.file.first);
+        d.file.second = (int)ReadUInt(is, 4);
+        datasets.push_back(std::move(d));
+    }
+
+    n = is ? ReadUInt(is, 4) : 0;
+    for (uint32_t i = 0; i < n && is; i++) {
+        Decorator d;
+        d.type = (DataType)ReadUInt(is, 4);
+        ReadStyle(is, d.properties);
+        ReadString(is, d.label);
+        ReadCoord(is, d.pos);
+        decorators.push_back(std::move(d));
+    }
+
+    if (version < 2) return;
+    ReadString(is, name);
+    ReadCoord(is, position);
+    ReadCoord(is, frame);
+    n = is ? ReadUInt(is, 4) : 0;
+    if (n && depth >= kMaxSnapshotDepth) { // corrupted snapshot : do not recurse forever
+        is.setstate(std::ios_base::failbit);
+        return;
+    }
+    for (uint32_t i = 0; i < n && is; i++) {
+        subpads.emplace_back();
+        subpads.back().ReadSnapshotContent(is, version, depth + 1);
+    }
+}
+
 } // namespace REx
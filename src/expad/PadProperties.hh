@@ -5,6 +5,7 @@
 
 #include "TString.h"
 
+#include <iosfwd>
 #include <utility>
 #include <vector>
 
@@ -37,7 +38,7 @@ struct PadProperties {
         Color color;
     };
 
-    // Data represented in the plot
+    // Data represented in the plot (copyable and movable: the strings are moved when the vectors grow)
     struct Data {
         DataType type;
         TString label;
@@ -45,7 +46,6 @@ struct PadProperties {
         DrawingStyle line;
         std::pair<TString, int> file; // filename ; number of columns
         Data();
-        Data(const Data& d);
     };
 
     struct Coord {
@@ -66,12 +66,27 @@ struct PadProperties {
         Decorator();
     };
 
+    TString name; // pad name
     TString title;
     AxisProperties xaxis;
     AxisProperties yaxis;
     std::vector<Data> datasets;
     std::vector<Decorator> decorators;
     unsigned short legend = 0;
+
+    // divided canvas : the properties of each subpad, with their position in the canvas (NDC)
+    std::vector<PadProperties> subpads;
+    Coord position; // area of the pad (subpads only)
+    Coord frame;    // area of the axes, inside the margins (subpads only)
+
+    // binary snapshot, to write the scripts again without the ROOT objects
+    static const unsigned short kSnapshotVersion = 2;
+    void WriteSnapshot(std::ostream& os) const;
+    bool ReadSnapshot(std::istream& is);
+
+private:
+    void WriteSnapshotContent(std::ostream& os) const;
+    void ReadSnapshotContent(std::istream& is, unsigned short version, int depth);
 };
 
 bool operator==(const PadProperties::Color& lc, const PadProperties::Color& rc);
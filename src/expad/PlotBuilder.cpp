@@ -0,0 +1,84 @@
+#include "PlotBuilder.hh"
+
+#include "TObject.h"
+
+#include <stdexcept>
+
+namespace REx {
+
+/// @param name plot name (default name of the exported files)
+/// @param title plot title
+PlotBuilder::PlotBuilder(const char* name, const char* title) : name_(name), title_(title), legend_(kNoLegend) {
+}
+
+/// @brief Add an object to the plot, as if it was drawn in a pad (data, text or line)
+/// @param obj object (not owned)
+/// @param option drawing option (e.g. "E", "HIST", "LP")
+PlotBuilder& PlotBuilder::Add(const TObject* obj, Option_t* option) {
+    if (!obj) throw std::invalid_argument("PlotBuilder: null object");
+    entries_.push_back({obj, option});
+    return *this;
+}
+
+PlotBuilder& PlotBuilder::SetTitle(const char* title) {
+    title_ = title;
+    return *this;
+}
+
+/// @brief Set the title of the x axis, and optionally its range (if min < max)
+PlotBuilder& PlotBuilder::SetXaxis(const char* title, double min, double max) {
+    xaxis_.title = title;
+    return SetXRange(min, max);
+}
+
+/// @brief Set the title of the y axis, and optionally its range (if min < max)
+PlotBuilder& PlotBuilder::SetYaxis(const char* title, double min, double max) {
+    yaxis_.title = title;
+    return SetYRange(min, max);
+}
+
+/// @brief Set the range of the x axis (min >= max : computed from the data)
+PlotBuilder& PlotBuilder::SetXRange(double min, double max) {
+    xaxis_.min = min;
+    xaxis_.max = max;
+    return *this;
+}
+
+/// @brief Set the range of the y axis (min >= max : computed from the data)
+PlotBuilder& PlotBuilder::SetYRange(double min, double max) {
+    yaxis_.min = min;
+    yaxis_.max = max;
+    return *this;
+}
+
+PlotBuilder& PlotBuilder::SetLogx(bool flag) {
+    xaxis_.log = flag;
+    return *this;
+}
+
+PlotBuilder& PlotBuilder::SetLogy(bool flag) {
+    yaxis_.log = flag;
+    return *this;
+}
+
+/// @brief Show a legend (the labels are the object titles, unless set with AddLegendEntry)
+PlotBuilder& PlotBuilder::SetLegend(LegendPosition position) {
+    legend_ = position;
+    return *this;
+}
+
+/// @brief Set the legend label of an object (also shows the legend, top right by default)
+PlotBuilder& PlotBuilder::AddLegendEntry(const TObject* obj, const char* label) {
+    if (!obj) throw std::invalid_argument("PlotBuilder: null object");
+    legendEntries_.push_back({obj, label});
+    if (legend_ == kNoLegend) legend_ = kTopRight;
+    return *this;
+}
+
+/// @brief Remove the objects and the legend entries, to describe another plot with the same settings
+void PlotBuilder::Clear() {
+    entries_.clear();
+    legendEntries_.clear();
+}
+
+} // namespace REx
@@ -0,0 +1,76 @@
+#ifndef PLOTBUILDER_HH
+#define PLOTBUILDER_HH
+
+#include "Rtypes.h"
+#include "TString.h"
+
+#include <utility>
+#include <vector>
+
+class TObject;
+
+namespace REx {
+
+/// @brief Description of a plot without any pad ("virtual pad"), for exports that never touch ROOT graphics
+///
+/// The objects are given with their drawing options, as they would be drawn in a pad (the first data object
+/// defines the frame). The axis ranges that are not set are computed from the data, with the rules of the ROOT
+/// painters. The objects are not owned and must stay alive until the plot is exported.
+///
+/// Usage:
+///     REx::PlotBuilder plot("c1", "My plot");
+///     plot.Add(h1, "E").Add(h2, "HIST");
+///     plot.SetLegend(REx::PlotBuilder::kTopRight).AddLegendEntry(h1, "data");
+///     plot.SetLogy();
+///     rex_python.ExportPlot(plot, "output/plot.py");
+class PlotBuilder {
+public:
+    enum LegendPosition { kNoLegend = 0, kTopLeft = 1, kTopRight = 2, kBottomLeft = 3, kBottomRight = 4 };
+
+    struct Axis {
+        TString title;       // default: title of the frame object axis
+        bool log = false;
+        double min = 0;      // range used if min < max (default: computed from the data)
+        double max = 0;
+    };
+
+    struct Entry {
+        const TObject* obj;
+        TString option;      // drawing option
+    };
+
+    explicit PlotBuilder(const char* name = "plot", const char* title = "");
+
+    PlotBuilder& Add(const TObject* obj, Option_t* option = "");
+    PlotBuilder& SetTitle(const char* title);
+    PlotBuilder& SetXaxis(const char* title, double min = 0, double max = 0);
+    PlotBuilder& SetYaxis(const char* title, double min = 0, double max = 0);
+    PlotBuilder& SetXRange(double min, double max);
+    PlotBuilder& SetYRange(double min, double max);
+    PlotBuilder& SetLogx(bool flag = true);
+    PlotBuilder& SetLogy(bool flag = true);
+    PlotBuilder& SetLegend(LegendPosition position);
+    PlotBuilder& AddLegendEntry(const TObject* obj, const char* label);
+    void Clear();
+
+    inline const TString& GetName() const { return name_; };
+    inline const TString& GetTitle() const { return title_; };
+    inline const Axis& GetXaxis() const { return xaxis_; };
+    inline const Axis& GetYaxis() const { return yaxis_; };
+    inline const std::vector<Entry>& GetEntries() const { return entries_; };
+    inline LegendPosition GetLegendPosition() const { return legend_; };
+    inline const std::vector<std::pair<const TObject*, TString>>& GetLegendEntries() const { return legendEntries_; };
+
+private:
+    TString name_;
+    TString title_;
+    Axis xaxis_;
+    Axis yaxis_;
+    std::vector<Entry> entries_;
+    LegendPosition legend_;
+    std::vector<std::pair<const TObject*, TString>> legendEntries_; // object ; label
+};
+
+} // namespace REx
+
+#endif
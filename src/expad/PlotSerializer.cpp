@@ -1,6 +1,10 @@
 #include "PlotSerializer.hh"
+#include "DataScan.hh"
 #include "Log.hh"
+#include "PlotBuilder.hh"
+#include "ROOTToText.hh"
 
+#include "TArrayD.h"
 #include "TColor.h"
 #include "TF1.h"
 #include "TGraph.h"
@@ -16,22 +20,132 @@
 #include "TROOT.h"
 #include "TString.h"
 #include "TText.h"
+#include "TVirtualPad.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace REx {
 
-PlotSerializer::PlotSerializer(TVirtualPad* pad, bool save_func) : pad_(pad), saveFunctions_(save_func) {
+/// @param fingerprints fingerprints of the objects of the pad already computed (see ComputePadHash), not kept
+PlotSerializer::PlotSerializer(TVirtualPad* pad, bool save_func, const FingerprintCache* fingerprints)
+    : pad_(pad), saveFunctions_(save_func), fingerprints_(fingerprints) {
     ExtractPadProperties();
+    fingerprints_ = nullptr;
+}
+
+/// @brief Serialize a plot described without pad (no painting: the missing axis ranges are computed from the data)
+PlotSerializer::PlotSerializer(const PlotBuilder& plot, bool save_func) : pad_(nullptr), saveFunctions_(save_func) {
+    ExtractPlotProperties(plot);
 }
 
 PlotSerializer::~PlotSerializer() {
 }
 
+/// @brief Copy of the extracted properties, to write the files in another thread (see CloneData)
+///
+/// The copy uses the data objects of the original: the fingerprints of the objects are not copied (no Update).
+PlotSerializer::PlotSerializer(const PlotSerializer& ps)
+    : pad_(ps.pad_), pp_(ps.pp_), dataObjects_(ps.dataObjects_), drawOptions_(ps.drawOptions_), frame_(ps.frame_),
+      stackLayers_(ps.stackLayers_), saveFunctions_(ps.saveFunctions_), previous_(ps.previous_), columns_(ps.columns_) {
+    for (const auto& sub : ps.subpads_)
+        subpads_.emplace_back(new PlotSerializer(*sub));
+}
+
+/// @brief Replace the data objects with copies owned by the serializer
+///
+/// Used by the asynchronous exports: once the copies are made, the objects of the pad can be modified or deleted.
+/// An object used by several datasets (e.g. a stack) is copied only once. The pad is not used afterwards.
+/// @param skip datasets of this pad that are not copied (e.g. data files not written again): they have no data object
+void PlotSerializer::CloneData(const std::vector<bool>* skip) {
+    std::map<const TObject*, const TObject*> copies; // original -> copy
+    auto clone = [&](const TObject* obj) -> const TObject* {
+        auto it = copies.find(obj);
+        if (it != copies.end()) return it->second;
+        TObject* copy = obj->Clone();
+        clones_.emplace_back(copy);
+        copies[obj] = copy;
+        return copy;
+    };
+    bool add_dir = TH1::AddDirectoryStatus();
+    TH1::AddDirectory(false); // the copies are not owned by the current directory
+    auto skipped = [skip](int i) { return skip && i < (int)skip->size() && (*skip)[i]; };
+    for (auto it = stackLayers_.begin(); it != stackLayers_.end();) {
+        if (skipped(it->first)) {
+            it = stackLayers_.erase(it);
+            continue;
+        }
+        it->second.first = static_cast<const THStack*>(clone(it->second.first));
+        ++it;
+    }
+    for (int i = 0; i < (int)dataObjects_.size(); i++)
+        dataObjects_[i] = skipped(i) ? nullptr : clone(dataObjects_[i]);
+    TH1::AddDirectory(add_dir);
+    objectIndex_.clear(); // only used during the extraction
+    nameIndex_.clear();
+    pad_ = nullptr;
+    for (auto& sub : subpads_)
+        sub->CloneData();
+}
+
 void PlotSerializer::Restart() {
-    pp_.datasets.clear();
-    pp_.decorators.clear();
+    if (!pad_) {
+        LOG_ERROR("Cannot serialize the plot again: the data objects were copied (CloneData)");
+        return;
+    }
+    Clear();
+    ExtractPadProperties();
+}
+
+/// @brief Serialize the pad again, extracting only the objects modified or added since the last serialization
+///
+/// The data objects and the legend are compared with their fingerprints (address, unique ID, style and content):
+/// the datasets of an unmodified object are reused, without extraction nor legend matching. The title, the axes
+/// and the decorators are always extracted again. A divided canvas is fully serialized again.
+/// @param fingerprints fingerprints of the objects of the pad already computed (see ComputePadHash), not kept
+/// @return number of datasets whose data changed (see GetPreviousIndex), -1 if the pad is not available
+int PlotSerializer::Update(const FingerprintCache* fingerprints) {
+    if (!pad_) {
+        LOG_ERROR("Cannot serialize the plot again: the data objects were copied (CloneData)");
+        return -1;
+    }
+    fingerprints_ = fingerprints;
+    int nchanged;
+    if (records_.empty() || !subpads_.empty()) {
+        Restart();
+        nchanged = pp_.datasets.size();
+    } else {
+        std::vector<PrimitiveRecord> previous = std::move(records_);
+        Clear();
+        ExtractPadProperties(&previous);
+        nchanged = std::count(previous_.begin(), previous_.end(), -1);
+    }
+    fingerprints_ = nullptr;
+    return nchanged;
+}
+
+/// @brief Remove the results of the last extraction
+void PlotSerializer::Clear() {
     dataObjects_.clear();
+    drawOptions_.clear();
+    frame_.clear();
+    objectIndex_.clear();
+    nameIndex_.clear();
+    stackLayers_.clear();
+    subpads_.clear();
+    records_.clear();
+    previous_.clear();
+    colors_.clear();
+    columns_ = PixelColumns();
     pp_ = PadProperties();
-    ExtractPadProperties();
+}
+
+int PlotSerializer::GetNumberOfSubpads() const {
+    return subpads_.size();
+}
+
+const PlotSerializer* PlotSerializer::GetSubpad(int i) const {
+    return subpads_.at(i).get();
 }
 
 int PlotSerializer::GetNumberOfDatasets() const {
@@ -59,98 +173,296 @@ int PlotSerializer::GetLegendPosition() const {
     return pp_.legend;
 }
 
+/// @brief Index of a dataset in the previous serialization (see Update)
+/// @return -1 if the data changed (or if the dataset is new): its data file must be written again
+int PlotSerializer::GetPreviousIndex(int i) const {
+    return i < (int)previous_.size() ? previous_[i] : -1;
+}
+
 /// @brief Extract the properties of all objects drawn in the current pad
-void PlotSerializer::ExtractPadProperties() {
-    bool axis_needed = true;
+/// @param previous records of the previous extraction: the unmodified objects are not extracted again (see Update)
+void PlotSerializer::ExtractPadProperties(const std::vector<PrimitiveRecord>* previous) {
+    Bool_t axis_needed = true;
     const TLegend* legend = nullptr;
-    for (const TObject* obj_p : *(pad_->GetListOfPrimitives())) {
+    pp_.name = pad_->GetName();
+    auto recorded = [](DataType data) { return GetDataDimension(data) == 1 || data == Legend; };
+
+    // fingerprints of the data objects and of the legend, with the record of the same object in the previous extraction
+    struct Item {
+        Fingerprint fp;
+        DataType type;
+        const PrimitiveRecord* prev;
+    };
+    // one dataset per primitive in most pads (stacks and multigraphs add more)
+    const size_t nprimitives = pad_->GetListOfPrimitives()->GetSize();
+    std::vector<Item> items;
+    items.reserve(nprimitives);
+    records_.reserve(nprimitives);
+    pp_.datasets.reserve(nprimitives);
+    dataObjects_.reserve(nprimitives);
+    drawOptions_.reserve(nprimitives);
+    std::vector<bool> used(previous ? previous->size() : 0, false);
+    size_t cursor = 0; // the drawing order rarely changes: search from the last match
+    auto find = [&](const Fingerprint& fp) -> const PrimitiveRecord* {
+        for (size_t n = 0; n < used.size(); n++) {
+            size_t k = (cursor + n) % used.size();
+            if (!used[k] && (*previous)[k].fp.SameObject(fp)) {
+                used[k] = true;
+                cursor = k + 1;
+                return &(*previous)[k];
+            }
+        }
+        return nullptr;
+    };
+    // fingerprint already computed for the pad hash, if any (same object and drawing option)
+    auto fingerprint = [this](const TObject* obj, Option_t* option) {
+        if (fingerprints_) {
+            auto it = fingerprints_->find({obj, option ? option : ""});
+            if (it != fingerprints_->end()) return it->second;
+        }
+        return Fingerprint::Compute(obj, option);
+    };
+    // the labels of the reused datasets are kept if the legend and the list of objects are the same
+    bool same_labels = previous != nullptr;
+    TListIter next(pad_->GetListOfPrimitives());
+    while (const TObject* obj_p = next()) {
+        if (obj_p->InheritsFrom(TVirtualPad::Class())) continue;
         DataType data = GetDataType(obj_p);
-        int dim = GetDataDimension(data);
-        if (dim == 1) {
-            // 1D data
-            StoreDataWithAxis(obj_p, data, axis_needed);
+        if (!recorded(data)) continue;
+        Item item{fingerprint(obj_p, next.GetOption()), data, nullptr};
+        if (previous) item.prev = find(item.fp);
+        if (!item.prev || (data == Legend && item.prev->fp != item.fp)) same_labels = false;
+        items.push_back(item);
+    }
+    if (std::find(used.begin(), used.end(), false) != used.end()) same_labels = false; // removed object
+
+    std::vector<bool> relabel; // datasets whose label is set from the legend
+    size_t n = 0;
+    for (const TObject* obj_p : *(pad_->GetListOfPrimitives())) {
+        if (obj_p->InheritsFrom(TVirtualPad::Class())) {
+            // divided canvas
+            StoreSubpad(static_cast<TVirtualPad*>(const_cast<TObject*>(obj_p)));
+            continue;
         }
-        else if (dim == 2 || dim == 3) {
-            LOG_WARN("2D/3D plots are not supported yet.");
-            // throw std::invalid_argument("2D/3D plots are not supported yet.");
+        if (n == items.size() || items[n].fp.obj != obj_p) {
+            StorePrimitive(obj_p, "", axis_needed, legend);
+            continue;
         }
-        else if (dim == 0) {
-            // other graphics entities (text, legend, ...)
-            switch (data) {
-                case TextBox:
-                    if (strcmp(obj_p->GetName(), "title") == 0) {
-                        // title of the plot
-                        pp_.title = ((TPaveText*)obj_p)->GetLine(0)->GetTitle();
-                    }
-                    break;
-                case Legend:
-                    if (legend)
-                        throw std::runtime_error("A legend has already been registered.");
-                    legend = dynamic_cast<const TLegend*>(obj_p);
-                    GetLegend(legend);
-                    break;
-                case BareText:
-                case Line:
-                    StoreDecorator(obj_p, data);
-                    break;
-                default:
-                    break;
-            }
+        const Item& item = items[n++];
+        PrimitiveRecord rec;
+        rec.fp = item.fp;
+        rec.type = item.type;
+        rec.first = pp_.datasets.size();
+        bool reuse = item.type != Legend && item.prev && item.prev->fp == item.fp;
+        if (reuse) {
+            ReplayRecord(*item.prev, axis_needed, !same_labels);
+            for (int k = 0; k < item.prev->count; k++)
+                previous_.push_back(item.prev->first + k);
+        }
+        else {
+            StorePrimitive(obj_p, "", axis_needed, legend);
+            int count = pp_.datasets.size() - rec.first;
+            bool same_data = item.prev && item.prev->fp.content == item.fp.content && item.prev->count == count;
+            for (int k = 0; k < count; k++)
+                previous_.push_back(same_data ? item.prev->first + k : -1);
         }
+        rec.count = pp_.datasets.size() - rec.first;
+        relabel.resize(pp_.datasets.size(), !reuse);
+        records_.push_back(std::move(rec));
     }
+    if (!subpads_.empty() && pp_.datasets.empty()) return; // canvas divided in subpads
+    CompleteProperties(legend, same_labels ? &relabel : nullptr);
+    SetPixelColumns();
+
+    // keep the results for the next update (the labels are final)
+    for (auto& rec : records_) {
+        rec.datasets.reserve(rec.count);
+        rec.objects.reserve(rec.count);
+        rec.options.reserve(rec.count);
+        for (int i = rec.first; i < rec.first + rec.count; i++) {
+            rec.datasets.push_back(pp_.datasets[i]);
+            rec.objects.push_back(dataObjects_[i]);
+            rec.options.push_back(drawOptions_[i]);
+        }
+        for (auto it = stackLayers_.lower_bound(rec.first); it != stackLayers_.end() && it->first < rec.first + rec.count; ++it)
+            rec.layers[it->first - rec.first] = it->second;
+    }
+}
+
+/// @brief Get the width of the frame in pixels and the visible x range (after the axis range is completed)
+void PlotSerializer::SetPixelColumns() {
+    columns_.n = std::lround(pad_->GetWw() * pad_->GetAbsWNDC() * (1 - pad_->GetLeftMargin() - pad_->GetRightMargin()));
+    columns_.xmin = pp_.xaxis.min;
+    columns_.xmax = pp_.xaxis.max;
+    columns_.logx = pp_.xaxis.log;
+}
+
+/// @brief Reuse the datasets of an unmodified object (its axis is extracted again if it is the frame object)
+/// @param reset_labels the legend changed: the labels are set back to the object titles
+void PlotSerializer::ReplayRecord(const PrimitiveRecord& record, Bool_t& axis_needed, bool reset_labels) {
+    int first = pp_.datasets.size();
+    for (int k = 0; k < record.count; k++) {
+        AddDataset(record.datasets[k], record.objects[k], record.options[k]);
+        if (reset_labels) pp_.datasets.back().label = record.objects[k]->GetTitle();
+    }
+    for (const auto& layer : record.layers)
+        stackLayers_[first + layer.first] = layer.second;
+    if (axis_needed) StoreAxis(record.fp.obj, record.type, first, axis_needed);
+}
+
+/// @brief Extract the properties of a plot described without pad
+///
+/// The settings of the description (title, axis, legend) replace the ones taken from the objects.
+void PlotSerializer::ExtractPlotProperties(const PlotBuilder& plot) {
+    bool axis_needed = true;
+    const TLegend* legend = nullptr;
+    const TObject* frame = nullptr; // first data object (title and axis of the plot)
+    pp_.name = plot.GetName();
+    pp_.xaxis.log = plot.GetXaxis().log;
+    pp_.yaxis.log = plot.GetYaxis().log;
+    for (const auto& entry : plot.GetEntries()) {
+        bool first = axis_needed;
+        StorePrimitive(entry.obj, entry.option, axis_needed, legend);
+        if (first && !axis_needed) frame = entry.obj;
+    }
+    // as in ROOT, the title of the plot is the title of the frame object
+    if (!plot.GetTitle().IsNull())
+        pp_.title = plot.GetTitle();
+    else if (frame && pp_.title.IsNull())
+        pp_.title = frame->GetTitle();
+    auto set_axis = [](PadProperties::AxisProperties& axis, const PlotBuilder::Axis& settings) {
+        if (!settings.title.IsNull()) axis.title = settings.title;
+        if (settings.min < settings.max) {
+            axis.min = settings.min;
+            axis.max = settings.max;
+        }
+    };
+    set_axis(pp_.xaxis, plot.GetXaxis());
+    set_axis(pp_.yaxis, plot.GetYaxis());
+    if (plot.GetLegendPosition() != PlotBuilder::kNoLegend) pp_.legend = plot.GetLegendPosition();
+
+    CompleteProperties(legend);
+
+    for (const auto& entry : plot.GetLegendEntries()) {
+        for (int i = 0; i < (int)dataObjects_.size(); i++) {
+            if (dataObjects_[i] == entry.first) pp_.datasets[i].label = entry.second;
+        }
+    }
+}
+
+/// @brief Extract the properties of an object of the plot (data, legend, text, etc.)
+/// @param obj object drawn in the plot
+/// @param option drawing option, if it is not available from the pad
+/// @param axis_needed true until the frame object (first data object) is found
+/// @param legend legend of the plot, if any
+void PlotSerializer::StorePrimitive(const TObject* obj, const TString& option, Bool_t& axis_needed, const TLegend*& legend) {
+    DataType data = GetDataType(obj);
+    int dim = GetDataDimension(data);
+    if (dim == 1) {
+        // 1D data
+        StoreDataWithAxis(obj, data, axis_needed, option);
+    }
+    else if (dim == 2 || dim == 3) {
+        LOG_WARN("2D/3D plots are not supported yet.");
+        // throw std::invalid_argument("2D/3D plots are not supported yet.");
+    }
+    else if (dim == 0) {
+        // other graphics entities (text, legend, ...)
+        switch (data) {
+            case TextBox:
+                if (strcmp(obj->GetName(), "title") == 0) {
+                    // title of the plot
+                    pp_.title = ((TPaveText*)obj)->GetLine(0)->GetTitle();
+                }
+                break;
+            case Legend:
+                if (legend)
+                    throw std::runtime_error("A legend has already been registered.");
+                legend = dynamic_cast<const TLegend*>(obj);
+                GetLegend(legend);
+                break;
+            case BareText:
+            case Line:
+                StoreDecorator(obj, data);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/// @brief Check the datasets, compute the missing axis ranges and set the labels from the legend
+/// @param relabel datasets whose label can be set from the legend by address (default: all)
+void PlotSerializer::CompleteProperties(const TLegend* legend, const std::vector<bool>* relabel) {
     if (!pp_.datasets.size())
         throw std::runtime_error("REx failed to export this plot (no compatible data was found).");
+    // the axis range is not available if the pad was never painted (e.g. no Update in batch mode)
+    if (pp_.xaxis.min >= pp_.xaxis.max || pp_.yaxis.min >= pp_.yaxis.max)
+        SetAxisRangeFromData();
     // update object labels if there is a legend
     if (legend) {
         for (const auto* legObj : *legend->GetListOfPrimitives()) {
             auto entry = static_cast<const TLegendEntry*>(legObj);
             const TObject* entry_obj = entry->GetObject();
             auto legend_label = entry->GetLabel();
-            bool found = false;
-            for (int i = 0; i < (int)dataObjects_.size(); i++) {
-                if (entry_obj == dataObjects_[i]) {
-                    pp_.datasets[i].label = legend_label;
-                    found = true;
-                    break; // object found : go to next legend entry
-                }
+            if (!entry_obj) continue; // header or text-only entry
+            int i = FindDataset(entry_obj);
+            if (i >= 0) {
+                if (!relabel || (*relabel)[i]) pp_.datasets[i].label = legend_label;
             }
-            if (!found) {
+            else {
                 // object not found... may be it is a clone (different address)
-                // --> so we will use the object name this time
-                auto entryName = entry_obj->GetName();
-                for (int i = 0; i < (int)dataObjects_.size(); i++) {
-                    if (strcmp(entryName, dataObjects_[i]->GetName()) == 0) {
-                        pp_.datasets[i].label = legend_label;
-                        break; // object found : go to next legend entry
-                    }
-                }
+                // --> so we will use the object name this time (names can change: always applied)
+                i = FindDataset(entry_obj->GetName());
+                if (i >= 0) pp_.datasets[i].label = legend_label;
             }
         }
     }
 }
 
+/// @brief Serialize a subpad, with its position in the canvas (a subpad without data is ignored)
+void PlotSerializer::StoreSubpad(TVirtualPad* pad) {
+    std::unique_ptr<PlotSerializer> sub;
+    try {
+        sub = std::make_unique<PlotSerializer>(pad, saveFunctions_, fingerprints_);
+    } catch (const std::runtime_error&) {
+        LOG_WARN("Subpad " << pad->GetName() << " ignored (no compatible data was found)");
+        return;
+    }
+    // absolute NDC coordinates, also for subpads of subpads
+    double x = pad->GetAbsXlowNDC();
+    double y = pad->GetAbsYlowNDC();
+    double w = pad->GetAbsWNDC();
+    double h = pad->GetAbsHNDC();
+    sub->pp_.position.set(x, y, x + w, y + h);
+    sub->pp_.frame.set(x + w * pad->GetLeftMargin(), y + h * pad->GetBottomMargin(),
+                       x + w * (1 - pad->GetRightMargin()), y + h * (1 - pad->GetTopMargin()));
+    pp_.subpads.push_back(sub->pp_);
+    subpads_.push_back(std::move(sub));
+}
+
 /// @brief Extract properties of a data object
 void PlotSerializer::StoreData(const TObject* obj, DataType data_type, const TString& extra_opts) {
     if (data_type == MultiGraph1D) {
-        TString opt(obj->GetDrawOption());
+        TString opt(pad_ ? obj->GetDrawOption() : "");
+        opt.Append(extra_opts);
         TListIter next(((TMultiGraph*)obj)->GetListOfGraphs());
         while (next()) {
-            opt.Append(next.GetOption());
-            StoreData(*next, Graph1D, opt);
+            // options of the multigraph + option of this graph
+            StoreData(*next, Graph1D, opt + next.GetOption());
         }
     }
     else if (data_type == MultiHisto1D) {
-        TString opt(obj->GetDrawOption());
+        TString opt(pad_ ? obj->GetDrawOption() : "");
+        opt.Append(extra_opts);
         opt.ToUpper();
-        TCollection* hlist = nullptr;
-        Bool_t dir = kIterForward;
-        if (opt.Contains("NOSTACK")) {
-            hlist = ((THStack*)obj)->GetHists();
-        }
-        else {
-            hlist = ((THStack*)obj->Clone())->GetStack();
-            dir = kIterBackward; // in case of stacked histogram, the last one is plotted first
-        }
+        auto hs = static_cast<const THStack*>(obj);
+        TList* hlist = hs->GetHists();
+        // stacked histograms are summed by RTT when saving the data (see ROOTToText::SaveStackLayer)
+        bool stacked = !opt.Contains("NOSTACK");
+        // in case of stacked histogram, the last one is plotted first
+        Bool_t dir = stacked ? kIterBackward : kIterForward;
+        int layer = hlist ? hlist->GetSize() : 0;
         // remove drawing options specific to THStack (not relevant for TH1)
         opt.ReplaceAll("NOSTACKB", 0x0);
         opt.ReplaceAll("NOSTACK", 0x0);
@@ -158,14 +470,17 @@ void PlotSerializer::StoreData(const TObject* obj, DataType data_type, const TSt
         opt.ReplaceAll("NOCLEAR", 0x0);
         TIter next(hlist, dir);
         while (next()) {
+            int idx = dataObjects_.size();
             StoreData(*next, Histo1D, opt);
+            if (stacked)
+                stackLayers_[idx] = std::make_pair(hs, --layer);
         }
     }
     else {
         PadProperties::Data prop;
         prop.type = data_type;
         prop.label = obj->GetTitle();
-        TString opt(obj->GetDrawOption());
+        TString opt(pad_ ? obj->GetDrawOption() : ""); // no pad: the options are given by the plot description
         opt.Append(obj->GetOption());
         if (extra_opts.Length()) opt.Append(extra_opts);
         opt.ToUpper();
@@ -197,8 +512,7 @@ void PlotSerializer::StoreData(const TObject* obj, DataType data_type, const TSt
                 prop.marker.style = 0;
             }
         }
-        pp_.datasets.push_back(prop);
-        dataObjects_.push_back(obj);
+        AddDataset(std::move(prop), obj, std::move(opt));
         if (saveFunctions_ && (data_type == Histo1D || data_type == Histo2D) && !opt.Contains("HIST")) {
             // also add functions from the list of functions associated to the histogram
             // (not drawn if the histo is plotted with 'HIST' option)
@@ -219,36 +533,76 @@ void PlotSerializer::StoreData(const TObject* obj, DataType data_type, const TSt
     }
 }
 
+/// @brief Register a dataset, with the data object and the drawing option used to write its data file
+void PlotSerializer::AddDataset(PadProperties::Data data, const TObject* obj, const TString& option) {
+    int idx = pp_.datasets.size();
+    pp_.datasets.push_back(std::move(data));
+    dataObjects_.push_back(obj);
+    drawOptions_.push_back(option);
+    // the first dataset of an object is the one labelled by the legend
+    objectIndex_.emplace(obj, idx);
+    nameIndex_.emplace(obj->GetName(), idx);
+}
+
+/// @brief Index of the first dataset of a data object (-1 if it is not drawn)
+int PlotSerializer::FindDataset(const TObject* obj) const {
+    auto it = objectIndex_.find(obj);
+    return it != objectIndex_.end() ? it->second : -1;
+}
+
+/// @brief Index of the first dataset whose data object has this name (-1 if none)
+int PlotSerializer::FindDataset(const char* name) const {
+    auto it = nameIndex_.find(name);
+    return it != nameIndex_.end() ? it->second : -1;
+}
+
 /// @brief Extract properties of a data object, and its associated axis
-void PlotSerializer::StoreDataWithAxis(const TObject* obj, DataType data_type, Bool_t& get_axis) {
-    StoreData(obj, data_type);
-    if (get_axis) {
-        const TH1* h = nullptr;
-        switch (data_type) {
-            case Histo1D:
-                h = (TH1*)obj;
-                break;
-            case Function1D:
-                h = ((TF1*)obj)->GetHistogram();
-                break;
-            case Graph1D:
-                h = ((TGraph*)obj)->GetHistogram();
-                break;
-            case MultiGraph1D:
+void PlotSerializer::StoreDataWithAxis(const TObject* obj, DataType data_type, Bool_t& get_axis, const TString& option) {
+    int first = pp_.datasets.size();
+    StoreData(obj, data_type, option);
+    if (get_axis) StoreAxis(obj, data_type, first, get_axis);
+}
+
+/// @brief Extract the axis of the frame object (first data object drawn)
+/// @param first index of the first dataset of the object
+void PlotSerializer::StoreAxis(const TObject* obj, DataType data_type, int first, Bool_t& get_axis) {
+    // datasets of the frame object (not the functions of the histograms)
+    DataType frame_type = data_type == MultiGraph1D ? Graph1D : data_type == MultiHisto1D ? Histo1D : data_type;
+    for (int i = first; i < (int)pp_.datasets.size(); i++) {
+        if (pp_.datasets[i].type == frame_type) frame_.push_back(i);
+    }
+    const TH1* h = nullptr;
+    switch (data_type) {
+        case Histo1D:
+            h = (TH1*)obj;
+            break;
+        case Function1D:
+            h = ((TF1*)obj)->GetHistogram();
+            break;
+        case Graph1D:
+            h = ((TGraph*)obj)->GetHistogram();
+            break;
+        // without pad, the axis of the first component is used (the stack/multigraph histogram needs painting)
+        case MultiGraph1D:
+            if (pad_)
                 h = ((TMultiGraph*)obj)->GetHistogram();
-                break;
-            case MultiHisto1D:
+            else if (first < (int)dataObjects_.size())
+                h = static_cast<const TGraph*>(dataObjects_[first])->GetHistogram();
+            break;
+        case MultiHisto1D:
+            if (pad_)
                 h = ((THStack*)obj)->GetHistogram();
-                break;
-            default:
-                throw std::invalid_argument("Unexpected data type (" + std::to_string(data_type) + ")");
-        }
-
-        if (GetAxis(h))
-            get_axis = false;
-        else
-            LOG_WARN("Could not get axis from " << obj->GetName());
+            else if (first < (int)dataObjects_.size())
+                h = static_cast<const TH1*>(dataObjects_[first]);
+            break;
+        default:
+            throw std::invalid_argument("Unexpected data type (" + std::to_string(data_type) + ")");
     }
+
+    if (GetAxis(h))
+        get_axis = false;
+    else
+        LOG_WARN("Could not get axis from " << obj->GetName());
 }
 
 /// @brief Extract properties of a decorator object
@@ -282,7 +636,7 @@ void PlotSerializer::StoreDecorator(const TObject* obj, DataType data_type) {
         default:
             break;
     }
-    pp_.decorators.push_back(deco);
+    pp_.decorators.push_back(std::move(deco));
 }
 
 /// @brief Extract axis information from an histogram
@@ -292,6 +646,11 @@ bool PlotSerializer::GetAxis(const TH1* h) {
     const TAxis* xx = h->GetXaxis();
     pp_.xaxis.title = xx->GetTitle();
     pp_.xaxis.color = GetColor(xx->GetAxisColor());
+    const TAxis* yy = h->GetYaxis();
+    pp_.yaxis.title = yy->GetTitle();
+    pp_.yaxis.color = GetColor(yy->GetAxisColor());
+    if (!pad_) return true; // not painted: no range
+
     if (pad_->GetLogx() == 1) {
         pp_.xaxis.min = pow(10, pad_->GetUxmin());
         pp_.xaxis.max = pow(10, pad_->GetUxmax());
@@ -303,9 +662,6 @@ bool PlotSerializer::GetAxis(const TH1* h) {
         pp_.xaxis.log = false;
     }
 
-    const TAxis* yy = h->GetYaxis();
-    pp_.yaxis.title = yy->GetTitle();
-    pp_.yaxis.color = GetColor(yy->GetAxisColor());
     if (pad_->GetLogy() == 1) {
         pp_.yaxis.min = pow(10, pad_->GetUymin());
         pp_.yaxis.max = pow(10, pad_->GetUymax());
@@ -320,6 +676,214 @@ bool PlotSerializer::GetAxis(const TH1* h) {
     return true;
 }
 
+/// @brief Compute the axis ranges that are not set, from the data of the frame object (first data object drawn)
+///
+/// The pad is not painted: the rules of the ROOT painters are applied to the data. Histograms, stacks and functions
+/// (THistPainter): bin edges in x, 5% margin in y with the minimum set to 0 for positive contents close to 0.
+/// Graphs (TGraphPainter) and multigraphs: 10% (5%) margins, without crossing 0. The user minimum/maximum of
+/// histograms, functions and graphs (SetMinimum/SetMaximum) are used.
+void PlotSerializer::SetAxisRangeFromData() {
+    if (frame_.empty()) return;
+    const int first = frame_[0];
+    const bool graph = pp_.datasets[first].type == Graph1D;
+    const bool logx = pp_.xaxis.log;
+    const bool logy = pp_.yaxis.log;
+
+    double xmin = INFINITY, xmax = -INFINITY, ymin = INFINITY, ymax = -INFINITY, ypos = INFINITY;
+    for (int i : frame_) {
+        double x1, x2, y1, y2, yp;
+        bool ok = false;
+        if (graph)
+            ok = GetGraphRange(static_cast<const TGraph*>(dataObjects_[i]), x1, x2, y1, y2, yp);
+        else if (pp_.datasets[i].type == Function1D)
+            ok = GetHistoRange(i, static_cast<const TF1*>(dataObjects_[i])->GetHistogram(), x1, x2, y1, y2, yp);
+        else
+            ok = GetHistoRange(i, static_cast<const TH1*>(dataObjects_[i]), x1, x2, y1, y2, yp);
+        if (!ok) continue;
+        xmin = std::min(xmin, x1);
+        xmax = std::max(xmax, x2);
+        ymin = std::min(ymin, y1);
+        ymax = std::max(ymax, y2);
+        ypos = std::min(ypos, yp);
+    }
+    if (xmin > xmax || ymin > ymax) {
+        LOG_WARN("Could not compute the axis range from the data");
+        return;
+    }
+
+    // minimum/maximum set by the user (not available for stacks and multigraphs)
+    double umin = -1111, umax = -1111;
+    if (frame_.size() == 1 && !stackLayers_.count(first)) {
+        const TObject* obj = dataObjects_[first];
+        const TH1* h = nullptr;
+        if (graph) {
+            umin = static_cast<const TGraph*>(obj)->GetMinimum();
+            umax = static_cast<const TGraph*>(obj)->GetMaximum();
+        }
+        else if (pp_.datasets[first].type == Function1D)
+            h = static_cast<const TF1*>(obj)->GetHistogram();
+        else
+            h = static_cast<const TH1*>(obj);
+        if (h) {
+            umin = h->GetMinimumStored();
+            umax = h->GetMaximumStored();
+        }
+    }
+
+    double ux1 = xmin, ux2 = xmax, uy1 = ymin, uy2 = ymax;
+    if (graph) {
+        if (xmin == xmax) xmax += 1;
+        if (ymin == ymax) ymax += 1;
+        double margin = frame_.size() > 1 ? 0.05 : 0.1; // TMultiGraph : 5%
+        double dx = margin * (xmax - xmin);
+        double dy = margin * (ymax - ymin);
+        ux1 = xmin - dx;
+        ux2 = xmax + dx;
+        if (ux1 < 0 && xmin >= 0) ux1 = logx ? 0.9 * xmin : 0;
+        if (ux2 > 0 && xmax <= 0) ux2 = 0;
+        if (logx && ux1 <= 0) ux1 = ux2 > 1000 ? 1 : 0.001 * ux2;
+        if (logy) {
+            if (ymin <= 0) ymin = ypos <= ymax ? ypos : 0.001 * ymax;
+            uy1 = ymin / (1 + 0.5 * log10(ymax / ymin));
+            uy2 = ymax * (1 + 0.2 * log10(ymax / ymin));
+        }
+        else {
+            uy1 = ymin - dy;
+            uy2 = ymax + dy;
+            if (uy1 < 0 && ymin >= 0) uy1 = 0;
+            if (uy2 > 0 && ymax <= 0) uy2 = 0;
+        }
+        if (umin != -1111) uy1 = umin;
+        if (umax != -1111) uy2 = umax;
+    }
+    else {
+        bool fixmin = umin != -1111;
+        bool fixmax = umax != -1111;
+        if (fixmin) uy1 = umin;
+        if (fixmax) uy2 = umax;
+        if (logy) {
+            if (ypos > ymax) LOG_WARN("No positive value for logarithmic axis");
+            else {
+                if (!fixmin) uy1 = 0.5 * ypos;
+                if (!fixmax) uy2 = 2 * ymax;
+            }
+        }
+        else {
+            if (uy2 <= uy1) {
+                if (uy1 > 0) uy1 = 0;
+                else if (uy1 < 0) uy2 = 0;
+                else uy2 = 1;
+            }
+            const double margin = 0.05; // gStyle->GetHistTopMargin()
+            if (!fixmin) {
+                double dy = margin * (uy2 - uy1);
+                if (uy1 >= 0 && uy1 - dy <= 0)
+                    uy1 = 0;
+                else
+                    uy1 -= dy;
+            }
+            if (!fixmax) uy2 += margin * (uy2 - uy1);
+        }
+    }
+
+    if (pp_.xaxis.min >= pp_.xaxis.max) {
+        pp_.xaxis.min = ux1;
+        pp_.xaxis.max = ux2;
+    }
+    if (pp_.yaxis.min >= pp_.yaxis.max) {
+        pp_.yaxis.min = uy1;
+        pp_.yaxis.max = uy2;
+    }
+}
+
+/// @brief Range of the data of a histogram dataset (sum of the layers for a stack, error bars if they are drawn)
+/// @param i dataset index
+/// @param h histogram (of the function for Function1D)
+/// @param ypos smallest positive value
+/// @return false if there is no finite value, or if the histograms of its stack have different binnings
+bool PlotSerializer::GetHistoRange(int i, const TH1* h, double& xmin, double& xmax, double& ymin, double& ymax, double& ypos) const {
+    if (!h) return false;
+    const TAxis* ax = h->GetXaxis();
+    int first = ax->GetFirst();
+    int last = ax->GetLast();
+    if (pp_.xaxis.log) {
+        // the bins with negative edges are not shown
+        while (first < last && ax->GetBinLowEdge(first) <= 0)
+            first++;
+    }
+    xmin = ax->GetBinLowEdge(first);
+    xmax = ax->GetBinUpEdge(last);
+
+    TString opt = i < (int)drawOptions_.size() ? drawOptions_[i] : "";
+    opt.ReplaceAll("SAME", "");
+    bool errors = opt.Contains("E") || (h->GetSumw2N() && opt.IsWhitespace()); // errors are drawn by default with Sumw2
+
+    std::unique_ptr<StackedHisto> sum;
+    auto layer = stackLayers_.find(i);
+    if (layer != stackLayers_.end()) {
+        // stacked histogram : range of the sum
+        sum = std::make_unique<StackedHisto>();
+        TIter next(layer->second.first->GetHists());
+        for (int k = 0; k <= layer->second.second; k++) {
+            if (!sum->Add(dynamic_cast<const TH1*>(next()))) {
+                // histograms with different binning (not written by RTT either)
+                LOG_WARN("Cannot stack histogram " << k << " in " << layer->second.first->GetName());
+                return false;
+            }
+        }
+    }
+    DataSummary ys;
+    const TArrayD* arr = dynamic_cast<const TArrayD*>(h);
+    if (!errors && sum) {
+        ys = ScanData(sum->GetArray() + first, last - first + 1);
+    }
+    else if (!errors && arr) {
+        // TH1D : use the array of contents directly (no copy)
+        ys = ScanData(arr->GetArray() + first, last - first + 1);
+    }
+    else {
+        std::vector<double> values;
+        values.reserve(2 * (last - first + 1));
+        for (int k = first; k <= last; k++) {
+            double y = sum ? sum->GetBinContent(k) : h->GetBinContent(k);
+            double e = errors ? (sum ? sum->GetBinError(k) : h->GetBinError(k)) : 0;
+            values.push_back(y - e);
+            values.push_back(y + e);
+        }
+        ys = ScanData(values.data(), values.size());
+    }
+    if (!ys.HasFinite()) return false;
+    ymin = ys.min;
+    ymax = ys.max;
+    ypos = ys.minPositive;
+    return true;
+}
+
+/// @brief Range of the points of a graph, including the error bars (TGraph::ComputeRange)
+/// @param ypos smallest positive y value
+/// @return false if there is no finite value
+bool PlotSerializer::GetGraphRange(const TGraph* gr, double& xmin, double& xmax, double& ymin, double& ymax, double& ypos) {
+    int np = gr->GetN();
+    auto scan = [np](const double* v, const double* elow, const double* ehigh) {
+        if (!elow && !ehigh) return ScanData(v, np);
+        std::vector<double> buffer(2 * np);
+        for (int k = 0; k < np; k++) {
+            buffer[k] = v[k] - (elow ? elow[k] : 0);
+            buffer[k + np] = v[k] + (ehigh ? ehigh[k] : 0);
+        }
+        return ScanData(buffer.data(), 2 * np);
+    };
+    DataSummary xs = scan(gr->GetX(), gr->GetEXlow(), gr->GetEXhigh());
+    DataSummary ys = scan(gr->GetY(), gr->GetEYlow(), gr->GetEYhigh());
+    if (!xs.HasFinite() || !ys.HasFinite()) return false;
+    xmin = xs.min;
+    xmax = xs.max;
+    ymin = ys.min;
+    ymax = ys.max;
+    ypos = ys.minPositive;
+    return true;
+}
+
 /// @brief Store the legend position and labels
 bool PlotSerializer::GetLegend(const TLegend* leg) {
     if (!leg) return false;
@@ -332,21 +896,21 @@ bool PlotSerializer::GetLegend(const TLegend* leg) {
     for (const TObject* obj : *leg->GetListOfPrimitives()) {
         const TLegendEntry* entry = static_cast<const TLegendEntry*>(obj);
         const TObject* entry_obj = entry->GetObject();
+        if (!entry_obj) continue; // header or text-only entry
         TString label = entry->GetLabel();
         if (label.CompareTo(entry_obj->GetTitle()) == 0) continue; // the label is the object title, no need to change anything
-        for (int i = 0; i < (int)dataObjects_.size(); i++) {
-            if (dataObjects_[i] == entry_obj) {
-                pp_.datasets.at(i).label = label;
-                break; // obj found : end the loop
-            }
-        }
+        int i = FindDataset(entry_obj);
+        if (i >= 0) pp_.datasets[i].label = label;
     }
     return true;
 }
 
+/// @brief RGBA values of a ROOT color index (each index is looked up once per extraction)
 PadProperties::Color PlotSerializer::GetColor(Color_t ci) const {
+    auto it = colors_.find(ci);
+    if (it != colors_.end()) return it->second;
     TColor* color = gROOT->GetColor(ci);
-    PadProperties::Color c;
+    PadProperties::Color& c = colors_[ci];
     if (color) {
         c.red = color->GetRed();
         c.green = color->GetGreen();
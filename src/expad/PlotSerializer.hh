@@ -2,40 +2,87 @@
 #define PLOTSERIALIZER_HH
 
 #include "DataType.hh"
+#include "Decimation.hh"
+#include "Fingerprint.hh"
 #include "PadProperties.hh"
 
 #include "Rtypes.h"
 #include "TString.h"
 
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 class TH1;
+class THStack;
+class TGraph;
 class TVirtualPad;
 class TLegend;
 class TObject;
 
 namespace REx {
 
+class PlotBuilder;
+
 /// @brief Extracts the properties of a plot (content and style)
 class PlotSerializer {
 public:
-    PlotSerializer(TVirtualPad* pad, bool save_func = true);
+    PlotSerializer(TVirtualPad* pad, bool save_func = true, const FingerprintCache* fingerprints = nullptr);
+    PlotSerializer(const PlotBuilder& plot, bool save_func = true);
     ~PlotSerializer();
 
     void Restart();
+    int Update(const FingerprintCache* fingerprints = nullptr);
+    void CloneData(const std::vector<bool>* skip = nullptr);
 
     // public member functions for checking serialization output
+    int GetNumberOfSubpads() const;
+    const PlotSerializer* GetSubpad(int i) const;
     int GetNumberOfDatasets() const;
     TString GetDatasetTitle(int i) const;
     TString GetPlotTitle() const;
     TString GetXaxisTitle() const;
     TString GetYaxisTitle() const;
     int GetLegendPosition() const;
+    int GetPreviousIndex(int i) const;
+    inline const PixelColumns& GetPixelColumns() const { return columns_; };
 
 private:
-    void ExtractPadProperties();
+    PlotSerializer(const PlotSerializer& ps);
+
+    /// @brief Extraction of a data object or of the legend, reused by Update while the object is not modified
+    struct PrimitiveRecord {
+        Fingerprint fp;
+        DataType type;
+        int first = 0; // index of the first dataset of the object
+        int count = 0; // number of datasets (data object and functions of a histogram, components of a stack...)
+        std::vector<PadProperties::Data> datasets; // with the labels set from the legend
+        std::vector<const TObject*> objects;
+        std::vector<TString> options;
+        std::map<int, std::pair<const THStack*, int>> layers; // relative dataset index -> (stack, layer)
+    };
+
+    void ExtractPadProperties(const std::vector<PrimitiveRecord>* previous = nullptr);
+    void ExtractPlotProperties(const PlotBuilder& plot);
+    void StorePrimitive(const TObject* obj, const TString& option, Bool_t& axis_needed, const TLegend*& legend);
+    void CompleteProperties(const TLegend* legend, const std::vector<bool>* relabel = nullptr);
+    void AddDataset(PadProperties::Data data, const TObject* obj, const TString& option);
+    int FindDataset(const TObject* obj) const;
+    int FindDataset(const char* name) const;
     void StoreData(const TObject* obj, DataType data_type, const TString& extra_opts = "");
-    void StoreDataWithAxis(const TObject* obj, DataType data_type, Bool_t& get_axis);
+    void StoreDataWithAxis(const TObject* obj, DataType data_type, Bool_t& get_axis, const TString& option = "");
+    void StoreAxis(const TObject* obj, DataType data_type, int first, Bool_t& get_axis);
+    void ReplayRecord(const PrimitiveRecord& record, Bool_t& axis_needed, bool reset_labels);
+    void Clear();
+    void SetPixelColumns();
     void StoreDecorator(const TObject* obj, DataType data_type);
+    void StoreSubpad(TVirtualPad* pad);
     bool GetAxis(const TH1* h);
+    void SetAxisRangeFromData();
+    bool GetHistoRange(int i, const TH1* h, double& xmin, double& xmax, double& ymin, double& ymax, double& ypos) const;
+    static bool GetGraphRange(const TGraph* gr, double& xmin, double& xmax, double& ymin, double& ymax, double& ypos);
     bool GetLegend(const TLegend* leg);
     PadProperties::Color GetColor(Color_t color) const;
 
@@ -43,9 +90,22 @@ private:
     TVirtualPad* pad_;
     PadProperties pp_;
     std::vector<const TObject*> dataObjects_;
+    std::vector<TString> drawOptions_; // drawing option of each dataset (upper case, with the options of the parent stack/multigraph)
+    std::vector<int> frame_;           // datasets of the first data object drawn (it defines the axis range)
+    std::unordered_map<const TObject*, int> objectIndex_; // first dataset of each data object (legend matching)
+    std::unordered_map<std::string, int> nameIndex_;      // first dataset of each object name (legend entries of clones)
+    std::map<int, std::pair<const THStack*, int>> stackLayers_; // dataset index -> (stack, layer) for stacked histograms
     Bool_t saveFunctions_;
+    std::vector<std::unique_ptr<TObject>> clones_; // copies of the data objects (see CloneData)
+    std::vector<std::unique_ptr<PlotSerializer>> subpads_; // divided canvas (pp_.subpads are the properties of the subpads)
+    std::vector<PrimitiveRecord> records_; // data objects and legend of the last extraction, in drawing order (see Update)
+    std::vector<int> previous_;            // index of each dataset in the previous extraction, -1 if its data changed
+    PixelColumns columns_; // pixel columns of the frame and visible x range (decimation of the graphs)
+    mutable std::unordered_map<Color_t, PadProperties::Color> colors_; // colors used in the pad (cleared at each extraction)
+    const FingerprintCache* fingerprints_ = nullptr; // fingerprints already computed (only during the extraction)
 
     friend class BaseExportManager;
+    friend class IncrementalExport;
 };
 
 } // namespace REx
@@ -75,11 +75,22 @@ namespace REx {
 PyplotExportManager::PyplotExportManager() {
     ext_ = ".py";
     com_ = '#';
+    contentType_ = "text/x-python";
 }
 
 PyplotExportManager::~PyplotExportManager() {
 }
 
+/// @brief Set to true to zoom into the graph lines with all their points while opening the scripts quickly
+///
+/// The graphs drawn with a line and without markers or error bars are saved as level-of-detail pyramids (see
+/// ROOTToText::SaveGraphPyramid), whose coarsest level has about 4 points per pixel column of the frame. The script
+/// draws this level, and reads the finer levels from the data file when the x range of the axes changes (zoom or pan
+/// in an interactive window). It takes precedence over EnableDecimation for these graphs.
+void PyplotExportManager::EnableLevelOfDetail(bool flag) {
+    lod_ = flag;
+}
+
 TString PyplotExportManager::FormatLabel(const TString& str) const {
     TString ltx = VirtualExportManager::FormatLabel(str, false); // do not escape characters
     if (latex_) {
@@ -92,18 +103,43 @@ char* PyplotExportManager::getColor(PadProperties::Color c) const {
     return Form("(%.3g,%.3g,%.3g)", c.red, c.green, c.blue);
 }
 
-void PyplotExportManager::WriteToFile(const char* filename, const PadProperties& pp) const {
-    std::ofstream ofs(filename);
-    if (!ofs.is_open()) {
+bool PyplotExportManager::WriteToFile(const char* filename, const PadProperties& pp) const {
+    std::ofstream ofs;
+    if (!sink_->Open(filename, ofs)) {
         LOG_ERROR("Could not open file " << filename);
-        return;
+        return false;
     }
 
     // write default header for configuration (import libraries) and set output name
     InitFile(ofs);
 
-    ofs << "fig, ax = plt.subplots()" << std::endl;
+    if (pp.subpads.empty()) {
+        ofs << "fig, ax = plt.subplots()" << std::endl;
+        SetPad(ofs, pp);
+    }
+    else {
+        // divided canvas : one axes per subpad
+        ofs << "fig = plt.figure()" << std::endl;
+        SetSubpads(ofs, pp);
+    }
+
+    TString outfile(gSystem->BaseName(filename));    // outfile : *.py
+    outfile.Replace(outfile.Index(ext_), 4, ".pdf"); // outfile : *.pdf
+
+    ofs << "plt.savefig(\'" << outfile << "\')\n"
+        << "# plt.show()\n"
+        << "# plt.close()"
+        << std::endl;
 
+    if (!sink_->Close(filename, ofs, contentType_)) {
+        LOG_ERROR("Could not write file " << filename);
+        return false;
+    }
+    return true;
+}
+
+/// @brief Plot the content of one pad in the current axes (ax)
+void PyplotExportManager::SetPad(std::ofstream& ofs, const PadProperties& pp) const {
     // >>> plot data
     SetTitleAndAxis(ofs, pp);
 
@@ -117,22 +153,95 @@ void PyplotExportManager::WriteToFile(const char* filename, const PadProperties&
 
     // plot other graphical elements
     SetDecorators(ofs, pp);
+}
 
-    TString outfile(gSystem->BaseName(filename));    // outfile : *.py
-    outfile.Replace(outfile.Index(ext_), 4, ".pdf"); // outfile : *.pdf
-
-    ofs << "plt.savefig(\'" << outfile << "\')\n"
-        << "# plt.show()\n"
-        << "# plt.close()"
-        << std::endl;
-
-    ofs.close();
+/// @brief Plot the subpads, each one in axes at the position of its frame in the canvas
+void PyplotExportManager::SetSubpads(std::ofstream& ofs, const PadProperties& pp) const {
+    for (const auto& sub : pp.subpads) {
+        if (sub.datasets.size()) {
+            const auto& f = sub.frame;
+            ofs << "\n# subpad " << sub.name << "\n"
+                << "ax = fig.add_axes([" << f.x1 << ", " << f.y1 << ", " << f.x2 - f.x1 << ", " << f.y2 - f.y1 << "])" << std::endl;
+            SetPad(ofs, sub);
+        }
+        SetSubpads(ofs, sub);
+    }
 }
 
 void PyplotExportManager::InitFile(std::ofstream& ofs) const {
+    if (lod_) ofs << "import io\n";
     ofs << "import numpy as np\n"
         << "import matplotlib.pyplot as plt\n"
         << std::endl;
+    if (lod_) InitLevelOfDetail(ofs);
+}
+
+/// @brief Write the python helper that reads the level-of-detail pyramids (see ROOTToText::SaveGraphPyramid)
+///
+/// The coarsest level of each line is loaded first. When the x range of the axes changes, the line is drawn with
+/// the coarsest level that has enough visible points: only this level is read from the file (and kept in memory).
+void PyplotExportManager::InitLevelOfDetail(std::ofstream& ofs) const {
+    ofs << "class LevelOfDetail:\n"
+        << "    \"\"\"Lines read from level-of-detail pyramids, the finer levels are read when zooming in\"\"\"\n"
+        << "\n"
+        << "    def __init__(self, points=2000):\n"
+        << "        self.points = points  # minimum number of visible points\n"
+        << "        self.index = {}\n"
+        << "        self.cache = {}\n"
+        << "\n"
+        << "    def levels(self, path):\n"
+        << "        \"\"\"Size of the header and levels (k, rows, offset), coarsest first\"\"\"\n"
+        << "        if path not in self.index:\n"
+        << "            start, levels = 0, []\n"
+        << "            with open(path, \"rb\") as f:\n"
+        << "                for line in f:\n"
+        << "                    if not line.startswith(b\"#\"):\n"
+        << "                        break\n"
+        << "                    start += len(line)\n"
+        << "                    w = line.split()\n"
+        << "                    if len(w) == 10 and w[1] == b\"LOD\" and w[2] == b\"level\":\n"
+        << "                        levels.append((int(w[3]), int(w[7]), int(w[9])))\n"
+        << "            self.index[path] = (start, levels)\n"
+        << "        return self.index[path]\n"
+        << "\n"
+        << "    def load(self, path, k=-1):\n"
+        << "        \"\"\"Columns of the level k (default: coarsest level)\"\"\"\n"
+        << "        start, levels = self.levels(path)\n"
+        << "        if not levels:\n"
+        << "            return np.transpose(np.loadtxt(path))\n"
+        << "        i = 0 if k < 0 else [l[0] for l in levels].index(k)\n"
+        << "        key = (path, levels[i][0])\n"
+        << "        if key not in self.cache:\n"
+        << "            with open(path, \"rb\") as f:\n"
+        << "                f.seek(start + levels[i][2])\n"
+        << "                raw = f.read(levels[i + 1][2] - levels[i][2]) if i + 1 < len(levels) else f.read()\n"
+        << "            self.cache[key] = np.transpose(np.loadtxt(io.BytesIO(raw), ndmin=2))\n"
+        << "        return self.cache[key]\n"
+        << "\n"
+        << "    def add(self, ax, line, path):\n"
+        << "        \"\"\"Draw the line with the coarsest level that has enough visible points, when the x range changes\"\"\"\n"
+        << "        levels = self.levels(path)[1]\n"
+        << "        if not levels:\n"
+        << "            return\n"
+        << "\n"
+        << "        def update(axes):\n"
+        << "            x1, x2 = sorted(axes.get_xlim())\n"
+        << "            d = self.load(path)\n"
+        << "            visible = max(np.count_nonzero((d[0] >= x1) & (d[0] <= x2)), 1)\n"
+        << "            for k, rows, offset in levels:\n"
+        << "                if k == 0 or visible * 4 ** (levels[0][0] - k) >= self.points:\n"
+        << "                    break\n"
+        << "            d = self.load(path, k)\n"
+        << "            i1, i2 = np.searchsorted(d[0], [x1, x2])\n"
+        << "            i1, i2 = max(i1 - 1, 0), min(i2 + 1, len(d[0]))\n"
+        << "            line.set_data(d[0][i1:i2], d[1][i1:i2])\n"
+        << "\n"
+        << "        ax.callbacks.connect(\"xlim_changed\", update)\n"
+        << "        update(ax)\n"
+        << "\n"
+        << "\n"
+        << "lod = LevelOfDetail()\n"
+        << std::endl;
 }
 
 void PyplotExportManager::SetTitleAndAxis(std::ofstream& ofs, const PadProperties& pp) const {
@@ -178,13 +287,18 @@ void PyplotExportManager::SetTitleAndAxis(std::ofstream& ofs, const PadPropertie
 void PyplotExportManager::SetData(std::ofstream& ofs, const PadProperties& pp) const {
     int n = pp.datasets.size();
     for (int i = 0; i < n; i++) {
-        const auto di = pp.datasets[i];
-        // read data file
-        ofs << Form("d%d = np.transpose(np.loadtxt(\"%s\"))", i + 1, di.file.first.Data()) << std::endl;
+        const auto& di = pp.datasets[i];
+        // read data file (coarsest level of a pyramid)
+        const bool pyramid = lod_ && IsLineOnly(di, di.file.second);
+        if (pyramid)
+            ofs << Form("d%d = lod.load(\"%s\")", i + 1, di.file.first.Data()) << std::endl;
+        else
+            ofs << Form("d%d = np.transpose(np.loadtxt(\"%s\"))", i + 1, di.file.first.Data()) << std::endl;
         // setup options
         std::vector<std::pair<std::string, std::string>> options;
+        options.reserve(16);
         // errors (if any)
-        int ncol = pp.datasets[i].file.second;
+        int ncol = di.file.second;
         if (ncol == 3) {
             // y error bars
             options.push_back({"yerr", Form("d%d[2]", i + 1)});
@@ -195,7 +309,7 @@ void PyplotExportManager::SetData(std::ofstream& ofs, const PadProperties& pp) c
             options.push_back({"yerr", Form("d%d[3]", i + 1)});
         }
         // line style
-        auto li = pp.datasets[i].line;
+        const auto& li = di.line;
         if (li.style) {
             options.push_back({"color", getColor(li.color)});
             options.push_back({"", ""});
@@ -203,7 +317,7 @@ void PyplotExportManager::SetData(std::ofstream& ofs, const PadProperties& pp) c
                 options.push_back({"ls", py_line.at(li.style)});
             else
                 options.push_back({"ls", "\'-\'"});
-            if (pp.datasets[i].type == Histo1D)
+            if (di.type == Histo1D)
                 options.push_back({"ds", "\"steps-mid\""});
             if (li.size != 1) // 1 is the default size
                 options.push_back({"lw", std::to_string(li.size)});
@@ -213,7 +327,7 @@ void PyplotExportManager::SetData(std::ofstream& ofs, const PadProperties& pp) c
             options.push_back({"fmt", "\" \""});
         }
         // marker style
-        auto mi = pp.datasets[i].marker;
+        const auto& mi = di.marker;
         if (mi.style) {
             if (!li.style)
                 options.push_back({"color", getColor(mi.color)});
@@ -229,11 +343,13 @@ void PyplotExportManager::SetData(std::ofstream& ofs, const PadProperties& pp) c
             }
         }
         if (pp.legend)
-            options.push_back({"label", FormatLabel(pp.datasets[i].label).Data()});
+            options.push_back({"label", FormatLabel(di.label).Data()});
 
         // plot it
         if (ncol >= 3) // with error bars
             ofs << Form("ax.errorbar(d%d[0], d%d[1], ", i + 1, i + 1);
+        else if (pyramid) // line updated when zooming
+            ofs << Form("l%d, = ax.plot(d%d[0], d%d[1], ", i + 1, i + 1, i + 1);
         else // without error bars
             ofs << Form("ax.plot(d%d[0], d%d[1], ", i + 1, i + 1);
         int nleft = options.size();
@@ -244,8 +360,10 @@ void PyplotExportManager::SetData(std::ofstream& ofs, const PadProperties& pp) c
                 ofs << "\n         ";
             nleft--;
         }
-        ofs << ")\n"
-            << std::endl;
+        ofs << ")" << std::endl;
+        if (pyramid)
+            ofs << Form("lod.add(ax, l%d, \"%s\")", i + 1, di.file.first.Data()) << std::endl;
+        ofs << std::endl;
     }
 }
 
@@ -13,8 +13,10 @@ public:
     PyplotExportManager();
     virtual ~PyplotExportManager();
 
+    void EnableLevelOfDetail(bool flag = true);
+
 protected:
-    virtual void WriteToFile(const char* filename, const PadProperties& pp) const;
+    virtual bool WriteToFile(const char* filename, const PadProperties& pp) const;
     virtual void SetTitleAndAxis(std::ofstream& ofs, const PadProperties& pp) const;
     virtual void SetData(std::ofstream& ofs, const PadProperties& pp) const;
     virtual void SetLegend(std::ofstream& ofs, const PadProperties& pp) const;
@@ -24,6 +26,9 @@ protected:
 
 private:
     void InitFile(std::ofstream& ofs) const;
+    void InitLevelOfDetail(std::ofstream& ofs) const;
+    void SetPad(std::ofstream& ofs, const PadProperties& pp) const;
+    void SetSubpads(std::ofstream& ofs, const PadProperties& pp) const;
     char* getColor(PadProperties::Color c) const;
 };
 } // namespace REx
@@ -0,0 +1,230 @@
+#include "WatchService.hh"
+#include "ExportManager.hh"
+#include "Fingerprint.hh"
+#include "Log.hh"
+
+#include "TROOT.h"
+#include "TVirtualPad.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+
+namespace REx {
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+double ms(clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+/// @brief Add a value to a running mean and maximum
+void AddValue(double value, int n, double& mean, double& max) {
+    mean += (value - mean) / n;
+    if (n == 1 || value > max) max = value;
+}
+
+} // namespace
+
+/// @brief Watched pad (the fields used by the writer thread are guarded by the mutex of the service)
+struct WatchService::Entry {
+    TVirtualPad* pad;
+    std::unique_ptr<IncrementalExport> exporter;
+    clock::duration interval;
+    Detection detection;
+    clock::time_point deadline; // next check of the pad
+    uint64_t hash = 0;          // hash of the objects at the last export (kContentHash)
+    bool exported = false;      // exported at least once
+    bool busy = false;          // files being written
+    int nstarted = 0;           // exports started
+    WatchStats stats;
+};
+
+/// @brief Pads, background writer (earliest deadline first) and statistics
+struct WatchService::State {
+    struct Task {
+        clock::time_point deadline;
+        unsigned long seq; // submission order, for equal deadlines
+        std::shared_ptr<Entry> entry;
+        std::function<bool()> write;
+        clock::time_point detected;
+        int ndatasets;
+    };
+    struct Later {
+        bool operator()(const Task& a, const Task& b) const {
+            return a.deadline > b.deadline || (a.deadline == b.deadline && a.seq > b.seq);
+        }
+    };
+
+    std::vector<std::shared_ptr<Entry>> entries;
+    std::priority_queue<Task, std::vector<Task>, Later> tasks;
+    unsigned long seq = 0;
+    int running = 0;
+    bool stop = false;
+    mutable std::mutex mutex;
+    std::condition_variable wake; // new task or stop
+    std::condition_variable idle; // task finished
+    std::thread writer;
+
+    void Run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [this] { return stop || !tasks.empty(); });
+            if (tasks.empty()) return; // stop
+            Task task = tasks.top();
+            tasks.pop();
+            running++;
+            lock.unlock();
+            bool ok = false;
+            try {
+                ok = task.write();
+            } catch (const std::exception& e) {
+                LOG_ERROR("Could not export pad " << task.entry->stats.pad << ": " << e.what());
+            }
+            double latency = ms(clock::now() - task.detected);
+            task.write = nullptr; // the copies of the data objects are deleted here
+            lock.lock();
+            running--;
+            auto& entry = *task.entry;
+            entry.stats.nexports++;
+            if (!ok) entry.stats.nfailed++;
+            entry.stats.ndatasets += task.ndatasets;
+            AddValue(latency, entry.stats.nexports, entry.stats.meanLatency, entry.stats.maxLatency);
+            entry.busy = false;
+            idle.notify_all();
+        }
+    }
+};
+
+/// @param managers export managers (not owned, they must not be modified while pads are watched)
+WatchService::WatchService(const std::vector<const BaseExportManager*>& managers) : managers_(managers), state_(new State) {
+    ROOT::EnableThreadSafety();
+    state_->writer = std::thread(&State::Run, state_.get());
+}
+
+/// @brief The exports in progress are finished
+WatchService::~WatchService() {
+    Flush();
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->stop = true;
+    }
+    state_->wake.notify_one();
+    state_->writer.join();
+}
+
+/// @brief Watch a pad: it is exported at the next Poll, then at most once per interval when it is modified
+/// @param pad pad to export (not owned, see Unwatch)
+/// @param interval_ms minimum time between two exports of the pad (ms)
+/// @param filename ouput script name (the extension of each manager is added, default: pad name)
+/// @param detection how the modifications are detected (a pad watched again is replaced)
+void WatchService::Watch(TVirtualPad* pad, double interval_ms, const char* filename, Detection detection) {
+    if (!pad) throw std::invalid_argument("WatchService: null pad");
+    if (interval_ms < 0) throw std::invalid_argument("WatchService: negative interval");
+    Unwatch(pad);
+    auto entry = std::make_shared<Entry>();
+    entry->pad = pad;
+    entry->exporter = std::make_unique<IncrementalExport>(pad, filename, managers_);
+    entry->interval = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::milli>(interval_ms));
+    entry->detection = detection;
+    entry->deadline = clock::now();
+    entry->stats.pad = pad->GetName();
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->entries.push_back(std::move(entry));
+}
+
+/// @brief Stop watching a pad (after the end of its export in progress, if any)
+void WatchService::Unwatch(TVirtualPad* pad) {
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    auto& entries = state_->entries;
+    auto it = std::find_if(entries.begin(), entries.end(), [pad](const std::shared_ptr<Entry>& e) { return e->pad == pad; });
+    if (it == entries.end()) return;
+    std::shared_ptr<Entry> entry = *it;
+    state_->idle.wait(lock, [&entry] { return !entry->busy; });
+    entries.erase(std::find(entries.begin(), entries.end(), entry));
+}
+
+/// @brief Check the pads whose deadline is reached, and start the export of the modified ones
+///
+/// Called from the thread that modifies the pads: the pads are serialized here, the files are written in the
+/// background. A pad whose files are still being written is checked again at the next call.
+/// @return number of exports started
+int WatchService::Poll() {
+    auto now = clock::now();
+    std::vector<std::shared_ptr<Entry>> due;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        for (const auto& e : state_->entries)
+            if (!e->busy && e->deadline <= now) due.push_back(e);
+    }
+    std::sort(due.begin(), due.end(), [](const std::shared_ptr<Entry>& a, const std::shared_ptr<Entry>& b) { return a->deadline < b->deadline; });
+
+    int nstarted = 0;
+    for (const auto& e : due) {
+        auto start = clock::now();
+        auto deadline = e->deadline;
+        e->deadline = start + e->interval;
+        uint64_t hash = 0;
+        FingerprintCache fingerprints; // reused by the serialization of the modified pad
+        bool modified = !e->exported;
+        if (e->detection == kModifiedBit) {
+            modified = modified || e->pad->IsModified();
+        }
+        else {
+            hash = ComputePadHash(e->pad, &fingerprints);
+            modified = modified || hash != e->hash;
+        }
+        auto detected = clock::now();
+        if (!modified) {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            e->stats.nunchanged++;
+            continue;
+        }
+
+        std::function<bool()> write;
+        try {
+            write = e->exporter->PrepareAsync(&fingerprints);
+        } catch (const std::exception& ex) {
+            LOG_ERROR("Could not export pad " << e->stats.pad << ": " << ex.what());
+        }
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (!write) {
+            e->stats.nfailed++;
+            continue;
+        }
+        e->hash = hash;
+        e->exported = true;
+        e->busy = true;
+        double delay = ms(start - deadline);
+        AddValue(delay, ++e->nstarted, e->stats.meanDelay, e->stats.maxDelay);
+        if (start - deadline > e->interval) e->stats.nlate++;
+        state_->tasks.push({deadline, state_->seq++, e, std::move(write), detected, e->exporter->GetNumberOfDatasetsWritten()});
+        state_->wake.notify_one();
+        nstarted++;
+    }
+    return nstarted;
+}
+
+/// @brief Wait for the end of the exports in progress
+void WatchService::Flush() {
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    state_->idle.wait(lock, [this] { return state_->tasks.empty() && state_->running == 0; });
+}
+
+/// @brief Statistics of the watched pads, in the order they were watched
+std::vector<WatchStats> WatchService::GetStats() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    std::vector<WatchStats> stats;
+    for (const auto& e : state_->entries)
+        stats.push_back(e->stats);
+    return stats;
+}
+
+} // namespace REx
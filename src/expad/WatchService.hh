@@ -0,0 +1,71 @@
+#ifndef WATCHSERVICE_HH
+#define WATCHSERVICE_HH
+
+#include "TString.h"
+
+#include <memory>
+#include <vector>
+
+class TVirtualPad;
+
+namespace REx {
+
+class BaseExportManager;
+
+/// @brief Export statistics of a watched pad (times in ms)
+struct WatchStats {
+    TString pad;              // pad name
+    int nexports = 0;         // exports finished
+    int nunchanged = 0;       // checks without modification (no export)
+    int nfailed = 0;          // exports with an error
+    int nlate = 0;            // exports started more than one interval after their deadline
+    long ndatasets = 0;       // datasets whose data files were written
+    double meanDelay = 0;     // start of the export - deadline (the service falls behind if it grows)
+    double maxDelay = 0;
+    double meanLatency = 0;   // modification detected - files written
+    double maxLatency = 0;
+};
+
+/// @brief Live re-export of monitored pads, at most once per refresh interval and only when they are modified
+///
+/// Each pad has a deadline: when it is reached, the pad is checked and, if it was modified since its last export,
+/// it is serialized incrementally in the calling thread (see IncrementalExport) and its files are written by a
+/// background thread, earliest deadline first. The updates of a pad that happen while it is waiting or being written
+/// are coalesced in its next export. The modification is detected with a hash of the objects drawn in the pad, or
+/// with the modified bit of the pad (cheaper, but reset only when the pad is painted).
+///
+/// Poll must be called regularly from the thread that modifies the pads (e.g. from a TTimer or the monitoring loop).
+/// The pads must be unwatched before they are deleted.
+///
+/// Usage:
+///     REx::WatchService watch({&rex_python});
+///     watch.Watch(c1, 2000, "output/live/c1"); // at most one export every 2 s
+///     while (running) {
+///         // ... fill the histograms, update the canvases ...
+///         watch.Poll();
+///     }
+///     watch.Flush();
+class WatchService {
+public:
+    enum Detection { kContentHash = 0, kModifiedBit = 1 };
+
+    explicit WatchService(const std::vector<const BaseExportManager*>& managers);
+    ~WatchService();
+
+    void Watch(TVirtualPad* pad, double interval_ms, const char* filename = "", Detection detection = kContentHash);
+    void Unwatch(TVirtualPad* pad);
+    int Poll();
+    void Flush();
+    std::vector<WatchStats> GetStats() const;
+
+private:
+    struct Entry;
+    struct State;
+
+    std::vector<const BaseExportManager*> managers_;
+    std::unique_ptr<State> state_; //! pads, background writer and statistics
+};
+
+} // namespace REx
+
+#endif
@@ -0,0 +1,257 @@
+#include "ArchiveSink.hh"
+#include "Log.hh"
+
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <vector>
+
+#ifdef REX_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef REX_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+const size_t kBlock = 512; // tar block size
+
+/// @brief Write an unsigned value in octal, in a null-terminated field of the tar header
+void SetOctal(char* field, size_t width, unsigned long long value) {
+    field[width - 1] = '\0';
+    for (size_t i = width - 1; i > 0; i--) {
+        field[i - 1] = '0' + (value & 7);
+        value >>= 3;
+    }
+}
+
+} // namespace
+
+namespace REx {
+
+/// @param filename archive file name (e.g. "plots.tar.gz")
+/// @param comp compression of the archive
+/// @param base_dir the entry names are relative to this directory (if the files are inside it)
+ArchiveSink::ArchiveSink(const char* filename, Compression comp, const char* base_dir)
+    : filename_(filename), comp_(comp), baseDir_(GetEntryName(base_dir)), open_(false), failed_(false), stream_(nullptr) {
+    if (!IsCompressionAvailable(comp))
+        throw std::invalid_argument("this compression is not available in this REx build");
+    if (baseDir_.Length() && !baseDir_.EndsWith("/"))
+        baseDir_.Append("/");
+
+    if (comp_ == kGzip) {
+#ifdef REX_WITH_ZLIB
+        stream_ = gzopen(filename, "wb");
+        open_ = (stream_ != nullptr);
+#endif
+    }
+    else {
+        ofs_.open(filename, std::ios::out | std::ios::binary);
+        open_ = ofs_.is_open();
+#ifdef REX_WITH_ZSTD
+        if (open_ && comp_ == kZstd) {
+            ZSTD_CCtx* cctx = ZSTD_createCCtx();
+            ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, 3);
+            stream_ = cctx;
+        }
+#endif
+    }
+    if (!open_) {
+        TString error_msg = "archive " + filename_ + " cannot be opened.";
+        throw std::runtime_error(error_msg.Data());
+    }
+}
+
+ArchiveSink::~ArchiveSink() {
+    Close();
+}
+
+/// @brief Check if REx was built with the library needed for this compression (zlib, zstd)
+bool ArchiveSink::IsCompressionAvailable(Compression comp) {
+    switch (comp) {
+        case kNone:
+            return true;
+        case kGzip:
+#ifdef REX_WITH_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case kZstd:
+#ifdef REX_WITH_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+/// @brief Add the content of the stream to the archive
+/// @return false if the file could not be added (the archive is marked as failed if it was partially written)
+bool ArchiveSink::Close(const char* path, std::ofstream& ofs, const char*) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string content;
+    if (!TakeBuffer(ofs, content)) return false;
+    if (!open_ || failed_) {
+        LOG_ERROR("Archive " << filename_ << " is " << (failed_ ? "truncated" : "closed") << ", cannot add " << path);
+        return false;
+    }
+    TString name = GetArchiveName(path);
+    if (names_.count(name.Data()))
+        LOG_WARN("File " << name << " is written twice in archive " << filename_);
+    // content padded to a full block
+    size_t padding = (kBlock - content.size() % kBlock) % kBlock;
+    content.append(padding, '\0');
+    if (!WriteHeader(name, content.size() - padding) || !Write(content.data(), content.size())) {
+        LOG_ERROR("Could not add " << name << " to archive " << filename_);
+        return false;
+    }
+    names_.insert(name.Data());
+    return true;
+}
+
+bool ArchiveSink::Exists(const char* path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return names_.count(GetArchiveName(path).Data()) > 0;
+}
+
+/// @brief Finalize the archive (end-of-archive blocks) and close the file
+/// @return false if the archive is incomplete (a write failed)
+bool ArchiveSink::Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_) return !failed_;
+    std::vector<char> eoa(2 * kBlock, '\0');
+    if (!failed_) Write(eoa.data(), eoa.size());
+#ifdef REX_WITH_ZLIB
+    if (comp_ == kGzip && gzclose((gzFile)stream_) != Z_OK) {
+        LOG_ERROR("Could not write archive " << filename_);
+        failed_ = true;
+    }
+#endif
+#ifdef REX_WITH_ZSTD
+    if (comp_ == kZstd) {
+        ZSTD_CCtx* cctx = (ZSTD_CCtx*)stream_;
+        std::vector<char> out(ZSTD_CStreamOutSize());
+        ZSTD_inBuffer input = {nullptr, 0, 0};
+        size_t remaining = 0;
+        do {
+            ZSTD_outBuffer output = {out.data(), out.size(), 0};
+            remaining = ZSTD_compressStream2(cctx, &output, &input, ZSTD_e_end);
+            if (ZSTD_isError(remaining)) {
+                LOG_ERROR("zstd compression error: " << ZSTD_getErrorName(remaining));
+                failed_ = true;
+                break;
+            }
+            ofs_.write(out.data(), output.pos);
+        } while (remaining);
+        ZSTD_freeCCtx(cctx);
+    }
+#endif
+    if (ofs_.is_open()) {
+        ofs_.close();
+        if (ofs_.fail()) failed_ = true;
+    }
+    stream_ = nullptr;
+    open_ = false;
+    return !failed_;
+}
+
+/// @brief Name of a file in the archive : relative to the base directory, without leading '/'
+TString ArchiveSink::GetArchiveName(const char* path) const {
+    TString name = GetEntryName(path);
+    if (baseDir_.Length() && name.BeginsWith(baseDir_))
+        name.Remove(0, baseDir_.Length());
+    while (name.BeginsWith("/"))
+        name.Remove(0, 1);
+    return name;
+}
+
+/// @brief Write the (ustar) header of a regular file
+bool ArchiveSink::WriteHeader(const TString& name, size_t size) {
+    char header[kBlock];
+    memset(header, 0, kBlock);
+    // name (100 chars) and prefix (155 chars) : long names are split on a '/'
+    Ssiz_t len = name.Length();
+    Ssiz_t split = -1;
+    if (len > 100) {
+        for (Ssiz_t s = 0; s < len && s <= 155; s++) {
+            if (name[s] == '/' && len - s - 1 <= 100 && len - s - 1 > 0) {
+                split = s;
+                break;
+            }
+        }
+        if (split < 0) {
+            LOG_ERROR("File name too long for the archive: " << name);
+            return false;
+        }
+        memcpy(header + 345, name.Data(), split);
+        memcpy(header, name.Data() + split + 1, len - split - 1);
+    }
+    else {
+        memcpy(header, name.Data(), len);
+    }
+    SetOctal(header + 100, 8, 0644);                  // mode
+    SetOctal(header + 108, 8, 0);                     // uid
+    SetOctal(header + 116, 8, 0);                     // gid
+    SetOctal(header + 124, 12, size);                 // size
+    SetOctal(header + 136, 12, (unsigned long long)time(nullptr)); // mtime
+    header[156] = '0';                                // regular file
+    memcpy(header + 257, "ustar", 6);                 // magic
+    memcpy(header + 263, "00", 2);                    // version
+    // checksum : sum of the header bytes, with the checksum field filled with spaces
+    memset(header + 148, ' ', 8);
+    unsigned int chksum = 0;
+    for (size_t i = 0; i < kBlock; i++)
+        chksum += (unsigned char)header[i];
+    SetOctal(header + 148, 7, chksum);
+    header[155] = ' ';
+    return Write(header, kBlock);
+}
+
+/// @brief Write data to the archive (through the compression stream, if any), the archive is marked as failed on error
+bool ArchiveSink::Write(const char* data, size_t size) {
+    if (!WriteData(data, size)) failed_ = true;
+    return !failed_;
+}
+
+bool ArchiveSink::WriteData(const char* data, size_t size) {
+#ifdef REX_WITH_ZLIB
+    if (comp_ == kGzip) {
+        gzFile gz = (gzFile)stream_;
+        while (size) {
+            unsigned int chunk = size > (1u << 30) ? (1u << 30) : (unsigned int)size;
+            if (gzwrite(gz, data, chunk) != (int)chunk) {
+                LOG_ERROR("Could not write to archive " << filename_);
+                return false;
+            }
+            data += chunk;
+            size -= chunk;
+        }
+        return true;
+    }
+#endif
+#ifdef REX_WITH_ZSTD
+    if (comp_ == kZstd) {
+        ZSTD_CCtx* cctx = (ZSTD_CCtx*)stream_;
+        std::vector<char> out(ZSTD_CStreamOutSize());
+        ZSTD_inBuffer input = {data, size, 0};
+        while (input.pos < input.size) {
+            ZSTD_outBuffer output = {out.data(), out.size(), 0};
+            size_t ret = ZSTD_compressStream2(cctx, &output, &input, ZSTD_e_continue);
+            if (ZSTD_isError(ret)) {
+                LOG_ERROR("zstd compression error: " << ZSTD_getErrorName(ret));
+                return false;
+            }
+            ofs_.write(out.data(), output.pos);
+        }
+        return ofs_.good();
+    }
+#endif
+    ofs_.write(data, size);
+    return ofs_.good();
+}
+
+} // namespace REx
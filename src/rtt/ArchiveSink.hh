@@ -0,0 +1,55 @@
+#ifndef ARCHIVESINK_HH
+#define ARCHIVESINK_HH
+
+#include "OutputSink.hh"
+
+#include <set>
+
+namespace REx {
+
+/// @brief Write all files in a single tar archive, optionally compressed (gzip or zstd)
+///
+/// The archive is written sequentially: each file is added when it is closed.
+/// The same sink can be shared by several export managers / pads, and it is finalized by Close() (or when deleted).
+/// After a write error, the archive is truncated: it is marked as failed, and no file can be added anymore.
+class ArchiveSink : public BufferedSink {
+public:
+    enum Compression {
+        kNone = 0,
+        kGzip = 1,
+        kZstd = 2
+    };
+
+    ArchiveSink(const char* filename, Compression comp = kNone, const char* base_dir = "");
+    virtual ~ArchiveSink();
+
+    bool Close(const char* path, std::ofstream& ofs, const char* content_type) override;
+    bool Exists(const char* path) override;
+
+    bool Close();
+    inline bool IsOpen() const { return open_; };
+    inline bool IsFailed() const { return failed_; };
+    inline int GetNumberOfEntries() const { return names_.size(); };
+
+    static bool IsCompressionAvailable(Compression comp);
+
+private:
+    TString GetArchiveName(const char* path) const;
+    bool WriteHeader(const TString& name, size_t size);
+    bool Write(const char* data, size_t size);
+    bool WriteData(const char* data, size_t size);
+
+private:
+    TString filename_;
+    Compression comp_;
+    TString baseDir_; // entry names are relative to this directory
+    bool open_;
+    bool failed_; // a write failed (truncated archive)
+    std::ofstream ofs_;
+    void* stream_; // compression stream (gzFile or ZSTD_CStream)
+    std::set<std::string> names_;
+};
+
+} // namespace REx
+
+#endif
@@ -0,0 +1,68 @@
+#include "ColumnData.hh"
+
+#include <iostream>
+
+namespace REx {
+
+/// @brief Number of rows (size of the shortest column)
+size_t ColumnData::GetNumberOfRows() const {
+    if (columns_.empty()) return 0;
+    size_t n = columns_[0].size;
+    for (const auto& c : columns_)
+        if (c.size < n) n = c.size;
+    return n;
+}
+
+/// @brief Get a column from its name (nullptr if not found)
+const ColumnData::Column* ColumnData::GetColumn(const char* name) const {
+    for (const auto& c : columns_)
+        if (c.name == name) return &c;
+    return nullptr;
+}
+
+/// @brief Get the values of a column from its name (nullptr if not found)
+const Double_t* ColumnData::GetData(const char* name) const {
+    const Column* c = GetColumn(name);
+    return c ? c->data : nullptr;
+}
+
+/// @brief Check if a column points to the storage of the object (no copy)
+bool ColumnData::IsView(const char* name) const {
+    const Column* c = GetColumn(name);
+    return c && c->view;
+}
+
+#ifdef REX_WITH_RVEC
+/// @brief Get a column as a RVec, which does not own the values (empty RVec if not found)
+ROOT::RVec<Double_t> ColumnData::GetRVec(const char* name) const {
+    const Column* c = GetColumn(name);
+    if (!c || !c->size) return ROOT::RVec<Double_t>();
+    return ROOT::RVec<Double_t>(const_cast<Double_t*>(c->data), c->size);
+}
+#endif
+
+void ColumnData::Print() const {
+    for (const auto& c : columns_)
+        std::cout << c.name << "[" << c.size << "]" << (c.view ? " (view)" : "") << std::endl;
+}
+
+void ColumnData::Clear() {
+    columns_.clear();
+    storage_.clear();
+}
+
+/// @brief Add a column pointing to existing values (they are not copied)
+void ColumnData::AddView(const char* name, const Double_t* data, size_t n) {
+    columns_.push_back({name, data, n, true});
+}
+
+/// @brief Add a column stored in this object
+/// @return pointer to the values, to be filled by the caller
+Double_t* ColumnData::AddColumn(const char* name, size_t n) {
+    storage_.emplace_back(n);
+    Double_t* data = storage_.back().data();
+    columns_.push_back({name, data, n, false});
+    return data;
+}
+
+} // namespace REx
@@ -0,0 +1,65 @@
+#ifndef COLUMNDATA_HH
+#define COLUMNDATA_HH
+
+#include "RVersion.h"
+#include "TString.h"
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 22, 0)
+#include "ROOT/RVec.hxx"
+#define REX_WITH_RVEC
+#endif
+
+#include <list>
+#include <vector>
+
+namespace REx {
+
+/// @brief Columns of an object, as they would be written by RTT (see ROOTToText::GetColumns)
+///
+/// When the values are already stored contiguously in the object (e.g. contents of a TH1D, points of a sorted TGraph),
+/// the column is a view on the object storage: the object must not be modified or deleted while the columns are used.
+/// Otherwise, the values are computed and stored in the ColumnData.
+///
+/// In PyROOT, use numpy.asarray(data.GetRVec("Y")) to get a NumPy array without copy.
+class ColumnData {
+public:
+    struct Column {
+        TString name;
+        const Double_t* data;
+        size_t size;
+        bool view; // true if data points to the storage of the object (no copy)
+        inline const Double_t* begin() const { return data; };
+        inline const Double_t* end() const { return data + size; };
+        inline Double_t operator[](size_t i) const { return data[i]; };
+    };
+
+    ColumnData() {};
+    ColumnData(const ColumnData&) = delete;
+    ColumnData& operator=(const ColumnData&) = delete;
+    ColumnData(ColumnData&&) = default;
+    ColumnData& operator=(ColumnData&&) = default;
+
+    inline size_t GetNumberOfColumns() const { return columns_.size(); };
+    size_t GetNumberOfRows() const;
+    inline const Column& GetColumn(size_t i) const { return columns_.at(i); };
+    const Column* GetColumn(const char* name) const;
+    const Double_t* GetData(const char* name) const;
+    bool IsView(const char* name) const;
+#ifdef REX_WITH_RVEC
+    ROOT::RVec<Double_t> GetRVec(const char* name) const;
+#endif
+    void Print() const;
+
+    // used by RTT to fill the columns
+    void Clear();
+    void AddView(const char* name, const Double_t* data, size_t n);
+    Double_t* AddColumn(const char* name, size_t n);
+
+private:
+    std::vector<Column> columns_;
+    std::list<std::vector<Double_t>> storage_; // values of the columns that are not views
+};
+
+} // namespace REx
+
+#endif
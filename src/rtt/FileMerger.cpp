@@ -0,0 +1,196 @@
+#include "FileMerger.hh"
+#include "Log.hh"
+#include "ROOTToText.hh"
+
+#include "TFile.h"
+#include "TGraph.h"
+#include "TH1.h"
+#include "TList.h"
+#include "TROOT.h"
+
+#include <atomic>
+#include <thread>
+
+namespace REx {
+
+FileMerger::FileMerger() {
+    nthreads_ = 0;
+    maxfiles_ = 0;
+}
+
+FileMerger::~FileMerger() {
+}
+
+/// @brief Add a ROOT file to merge
+void FileMerger::AddFile(const char* filename) {
+    files_.push_back(filename);
+}
+
+/// @brief Add an object to merge
+/// @param name name of the object in the files (may include directories, e.g. "dir/h")
+/// @param filename RTT output file name (default: name of the object)
+/// @param opt RTT option(s), see ROOTToText::PrintOptions()
+void FileMerger::AddObject(const char* name, const char* filename, Option_t* opt) {
+    requests_.push_back({name, filename, opt});
+}
+
+int FileMerger::GetNumberOfWorkers() const {
+    int n = nthreads_ > 0 ? nthreads_ : (int)std::thread::hardware_concurrency();
+    if (maxfiles_ > 0 && n > maxfiles_) n = maxfiles_;
+    if (n > (int)files_.size()) n = files_.size();
+    return n > 0 ? n : 1;
+}
+
+/// @brief Add an object to a partial sum (the object is owned by the sum afterwards, or deleted)
+bool FileMerger::Add(std::unique_ptr<TObject>& sum, TObject* obj, const char* filename) const {
+    if (!obj) return true;
+    std::unique_ptr<TObject> owned(obj);
+    if (!sum) {
+        sum = std::move(owned);
+        return true;
+    }
+    if (sum->IsA() != obj->IsA()) {
+        LOG_ERROR("Cannot merge " << obj->GetName() << " (" << obj->ClassName() << ") from " << filename
+                                  << " with an object of class " << sum->ClassName());
+        return false;
+    }
+    if (obj->InheritsFrom(TH1::Class())) {
+        if (!static_cast<TH1*>(sum.get())->Add(static_cast<TH1*>(obj))) {
+            LOG_ERROR("Cannot merge " << obj->GetName() << " from " << filename << " (different binning ?)");
+            return false;
+        }
+        return true;
+    }
+    // TGraph : the points are appended
+    TList list;
+    list.Add(obj);
+    return static_cast<TGraph*>(sum.get())->Merge(&list) >= 0;
+}
+
+/// @brief Add the objects of a file to the partial sums of a worker
+bool FileMerger::ReadFile(const char* filename, Partial& partial) const {
+    std::unique_ptr<TFile> file(TFile::Open(filename, "READ"));
+    if (!file || file->IsZombie()) {
+        LOG_ERROR("Could not open file " << filename);
+        return false;
+    }
+    bool res = true;
+    for (size_t k = 0; k < requests_.size(); k++) {
+        TObject* obj = file->Get(requests_[k].name);
+        if (!obj) {
+            LOG_WARN(requests_[k].name << " not found in " << filename);
+            continue;
+        }
+        if (obj->InheritsFrom(TH1::Class())) {
+            static_cast<TH1*>(obj)->SetDirectory(nullptr); // the histogram is not deleted with the file
+        }
+        else if (!obj->InheritsFrom(TGraph::Class())) {
+            LOG_ERROR("Cannot merge " << requests_[k].name << ": class " << obj->ClassName() << " is not supported");
+            delete obj;
+            res = false;
+            continue;
+        }
+        res = Add(partial[k], obj, filename) && res;
+    }
+    return res;
+}
+
+/// @brief Merge the objects of all the files
+/// @return false if a file could not be read or if an object could not be merged
+bool FileMerger::Merge() {
+    results_.clear();
+    if (files_.empty() || requests_.empty()) {
+        LOG_ERROR("No file or no object to merge");
+        return false;
+    }
+
+    const int nworkers = GetNumberOfWorkers();
+    if (nworkers > 1) ROOT::EnableThreadSafety();
+
+    std::vector<Partial> partials(nworkers);
+    for (auto& p : partials)
+        p.resize(requests_.size());
+
+    // each worker reads the next file in the list, until all files have been read
+    std::atomic<size_t> next(0);
+    std::atomic<bool> ok(true);
+    auto read = [&](int w) {
+        size_t i;
+        while ((i = next++) < files_.size()) {
+            if (!ReadFile(files_[i], partials[w]))
+                ok = false;
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int w = 1; w < nworkers; w++)
+        workers.emplace_back(read, w);
+    read(0);
+    for (auto& t : workers)
+        t.join();
+
+    // tree reduction of the partial sums : partials[i] += partials[i + stride]
+    for (int stride = 1; stride < nworkers; stride *= 2) {
+        auto reduce = [&](int i) {
+            for (size_t k = 0; k < requests_.size(); k++) {
+                if (!Add(partials[i][k], partials[i + stride][k].release(), "partial sum"))
+                    ok = false;
+            }
+        };
+        workers.clear();
+        for (int i = 2 * stride; i + stride < nworkers; i += 2 * stride)
+            workers.emplace_back(reduce, i);
+        reduce(0);
+        for (auto& t : workers)
+            t.join();
+    }
+
+    results_ = std::move(partials[0]);
+    for (size_t k = 0; k < requests_.size(); k++) {
+        if (!results_[k]) {
+            LOG_ERROR(requests_[k].name << " not found in any file");
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+/// @brief Save the merged objects with RTT (gRTT settings : directory, extension, output sink...)
+bool FileMerger::Save() const {
+    if (results_.size() != requests_.size()) {
+        LOG_ERROR("The objects must be merged before saving them");
+        return false;
+    }
+    bool res = true;
+    for (size_t k = 0; k < requests_.size(); k++) {
+        if (!results_[k]) continue;
+        TString filename(requests_[k].filename);
+        res = gRTT->SaveObject(results_[k].get(), filename.Data(), requests_[k].option) && res;
+    }
+    return res;
+}
+
+/// @brief Get a merged object from its name in the files (nullptr if not found or not merged yet)
+const TObject* FileMerger::GetResult(const char* name) const {
+    for (size_t k = 0; k < requests_.size() && k < results_.size(); k++) {
+        if (requests_[k].name == name) return results_[k].get();
+    }
+    return nullptr;
+}
+
+/// @brief Get the columns of a merged object in memory (with the RTT option given in AddObject)
+bool FileMerger::GetColumns(const char* name, ColumnData& data) const {
+    for (size_t k = 0; k < requests_.size() && k < results_.size(); k++) {
+        if (requests_[k].name == name && results_[k])
+            return gRTT->GetColumns(results_[k].get(), data, requests_[k].option);
+    }
+    LOG_ERROR("No merged object named " << name);
+    return false;
+}
+
+void FileMerger::Clear() {
+    files_.clear();
+    requests_.clear();
+    results_.clear();
+}
+
+} // namespace REx
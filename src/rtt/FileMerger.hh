@@ -0,0 +1,81 @@
+#ifndef FILEMERGER_HH
+#define FILEMERGER_HH
+
+#include "TObject.h"
+#include "TString.h"
+
+#include "ColumnData.hh"
+
+#include <memory>
+#include <vector>
+
+namespace REx {
+
+/// @brief Merge objects with the same name across many ROOT files, and save the results with RTT
+///
+/// Replaces 'hadd' followed by ROOTToText::SaveObject: the files are read once, in parallel,
+/// and each worker sums the objects of its files (only one file per worker is opened at a time).
+/// The partial sums of the workers are then combined by a parallel tree reduction.
+/// Supported objects: TH1 (including TH2) and TGraph.
+class FileMerger {
+public:
+    FileMerger();
+    ~FileMerger();
+
+    void AddFile(const char* filename);
+    void AddObject(const char* name, const char* filename = "", Option_t* opt = "");
+    inline void SetNumberOfThreads(int n);
+    inline void SetMaxOpenFiles(int n);
+    inline int GetNumberOfFiles() const;
+
+    bool Merge();
+    bool Save() const;
+    inline bool Run();
+
+    const TObject* GetResult(const char* name) const;
+    bool GetColumns(const char* name, ColumnData& data) const;
+    void Clear();
+
+private:
+    typedef std::vector<std::unique_ptr<TObject>> Partial; // one partial sum per object
+
+    struct Request {
+        TString name;     // name (path) of the object in the files
+        TString filename; // RTT output file name
+        TString option;   // RTT option(s)
+    };
+
+    int GetNumberOfWorkers() const;
+    bool Add(std::unique_ptr<TObject>& sum, TObject* obj, const char* filename) const;
+    bool ReadFile(const char* filename, Partial& partial) const;
+
+private:
+    std::vector<TString> files_;
+    std::vector<Request> requests_;
+    Partial results_;
+    int nthreads_;  // 0 : hardware concurrency
+    int maxfiles_;  // maximum number of files opened at the same time (0 : no limit)
+};
+
+/// @brief Set the number of threads (0 : number of cores)
+void FileMerger::SetNumberOfThreads(int n) {
+    nthreads_ = n > 0 ? n : 0;
+}
+
+/// @brief Set the maximum number of files opened at the same time, which bounds the memory usage (0 : no limit)
+void FileMerger::SetMaxOpenFiles(int n) {
+    maxfiles_ = n > 0 ? n : 0;
+}
+
+int FileMerger::GetNumberOfFiles() const {
+    return files_.size();
+}
+
+/// @brief Merge the objects and save them
+bool FileMerger::Run() {
+    return Merge() && Save();
+}
+
+} // namespace REx
+
+#endif
@@ -6,6 +6,14 @@
 
 // Turn on creation of additional dictionaries REx/RTT module
 #pragma link C++ class REx::ROOTToText;
+#pragma link C++ class REx::OutputSink;
+#pragma link C++ class REx::FileSink;
+#pragma link C++ class REx::MemorySink;
+#pragma link C++ struct REx::MemorySink::Entry;
+#pragma link C++ class REx::ArchiveSink;
+#pragma link C++ class REx::ColumnData;
+#pragma link C++ struct REx::ColumnData::Column;
+#pragma link C++ class REx::FileMerger;
 #pragma link C++ global gRTT;
 // #pragma link C++ typedef REx::rtt_writer;
 
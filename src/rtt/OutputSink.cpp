@@ -0,0 +1,114 @@
+#include "OutputSink.hh"
+#include "PathResolver.hh"
+
+#include "TSystem.h"
+
+namespace REx {
+
+FileSink* FileSink::GetInstance() {
+    // function-local static : the first call may come from several export threads at once
+    static FileSink* instance = new FileSink();
+    return instance;
+}
+
+bool FileSink::Open(const char* path, std::ofstream& ofs, std::ios_base::openmode mode) {
+    ofs.open(path, mode);
+    return ofs.is_open();
+}
+
+bool FileSink::Close(const char*, std::ofstream& ofs, const char*) {
+    bool ok = ofs.good(); // write errors
+    ofs.close();
+    return ok && !ofs.fail();
+}
+
+bool FileSink::Exists(const char* path) {
+    return !gSystem->AccessPathName(path, EAccessMode::kFileExists);
+}
+
+bool FileSink::IsDirectory(const char* dir) {
+    return PathResolver::GetInstance()->IsDirectory(dir);
+}
+
+bool FileSink::IsWritable(const char* dir) {
+    return PathResolver::GetInstance()->IsWritable(dir);
+}
+
+bool FileSink::MakeDirectory(const char* dir) {
+    return PathResolver::GetInstance()->MakeDirectory(dir);
+}
+
+/// @brief Redirect the stream to a memory buffer
+bool BufferedSink::Open(const char* path, std::ofstream& ofs, std::ios_base::openmode) {
+    if (!path || !path[0]) return false;
+    std::unique_ptr<std::stringbuf> buf(new std::stringbuf(std::ios_base::out));
+    // std::ofstream hides the basic_ios::rdbuf setter
+    static_cast<std::ostream&>(ofs).rdbuf(buf.get());
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_[&ofs] = std::move(buf);
+    return true;
+}
+
+/// @brief Get the content of the stream, and detach it from the memory buffer (the mutex must be locked)
+/// @return false if the stream was not opened by this sink
+bool BufferedSink::TakeBuffer(std::ofstream& ofs, std::string& content) {
+    auto it = buffers_.find(&ofs);
+    if (it == buffers_.end()) return false;
+    ofs.flush();
+    content = it->second->str();
+    static_cast<std::ostream&>(ofs).rdbuf(ofs.rdbuf()); // back to the (closed) file buffer
+    buffers_.erase(it);
+    return true;
+}
+
+/// @brief Name of the entry for a file path ("./dir//file.txt" -> "dir/file.txt")
+TString BufferedSink::GetEntryName(const char* path) {
+    TString name(path);
+    name.ReplaceAll("\\", "/");
+    while (name.Contains("//"))
+        name.ReplaceAll("//", "/");
+    while (name.Contains("/./"))
+        name.ReplaceAll("/./", "/");
+    while (name.BeginsWith("./"))
+        name.Remove(0, 2);
+    return name;
+}
+
+/// @brief Store the content of the stream
+bool MemorySink::Close(const char* path, std::ofstream& ofs, const char* content_type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string content;
+    if (!TakeBuffer(ofs, content)) return false;
+    Entry& entry = entries_[GetEntryName(path).Data()];
+    entry.content.swap(content);
+    entry.contentType = content_type ? content_type : "";
+    return true;
+}
+
+bool MemorySink::Exists(const char* path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.count(GetEntryName(path).Data()) > 0;
+}
+
+/// @brief Get an entry from its name (nullptr if not found)
+const MemorySink::Entry* MemorySink::GetEntry(const char* name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(GetEntryName(name).Data());
+    return it == entries_.end() ? nullptr : &it->second;
+}
+
+/// @brief Total size of the entries (bytes)
+size_t MemorySink::GetSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t size = 0;
+    for (const auto& e : entries_)
+        size += e.second.content.size();
+    return size;
+}
+
+void MemorySink::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+} // namespace REx
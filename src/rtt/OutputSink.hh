@@ -0,0 +1,101 @@
+#ifndef OUTPUTSINK_HH
+#define OUTPUTSINK_HH
+
+#include "TString.h"
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+namespace REx {
+
+/// @brief Destination of the files written by RTT and ExPad
+///
+/// The files are always written through a std::ofstream (the signature of the RTT custom writers),
+/// but a sink may redirect the stream to another buffer than a file on disk.
+class OutputSink {
+public:
+    virtual ~OutputSink() {};
+
+    virtual bool Open(const char* path, std::ofstream& ofs, std::ios_base::openmode mode = std::ios_base::out) = 0;
+    /// @brief Close a stream opened by Open (false if its content could not be written)
+    virtual bool Close(const char* path, std::ofstream& ofs, const char* content_type) = 0;
+
+    virtual bool Exists(const char* path) = 0;
+    virtual bool IsDirectory(const char* dir) = 0;
+    virtual bool IsWritable(const char* dir) = 0;
+    virtual bool MakeDirectory(const char* dir) = 0;
+};
+
+/// @brief Write files on disk (default sink)
+class FileSink : public OutputSink {
+public:
+    static FileSink* GetInstance();
+
+    bool Open(const char* path, std::ofstream& ofs, std::ios_base::openmode mode = std::ios_base::out) override;
+    bool Close(const char* path, std::ofstream& ofs, const char* content_type) override;
+
+    bool Exists(const char* path) override;
+    bool IsDirectory(const char* dir) override;
+    bool IsWritable(const char* dir) override;
+    bool MakeDirectory(const char* dir) override;
+
+private:
+    FileSink() {};
+};
+
+/// @brief Base class for the sinks that do not write files on disk: the streams are redirected to memory buffers
+///
+/// The entry names are the file paths without the leading "./",
+/// so that the relative paths written in the scripts match the entry names.
+class BufferedSink : public OutputSink {
+public:
+    virtual ~BufferedSink() {};
+
+    bool Open(const char* path, std::ofstream& ofs, std::ios_base::openmode mode = std::ios_base::out) override;
+
+    bool IsDirectory(const char*) override { return true; };
+    bool IsWritable(const char*) override { return true; };
+    bool MakeDirectory(const char*) override { return true; };
+
+    static TString GetEntryName(const char* path);
+
+protected:
+    bool TakeBuffer(std::ofstream& ofs, std::string& content);
+
+protected:
+    mutable std::mutex mutex_;
+
+private:
+    std::map<const std::ostream*, std::unique_ptr<std::stringbuf>> buffers_; // files currently opened
+};
+
+/// @brief Keep the files in memory (file name -> content)
+class MemorySink : public BufferedSink {
+public:
+    struct Entry {
+        std::string content;
+        std::string contentType;
+    };
+
+    MemorySink() {};
+    virtual ~MemorySink() {};
+
+    bool Close(const char* path, std::ofstream& ofs, const char* content_type) override;
+    bool Exists(const char* path) override;
+
+    const std::map<std::string, Entry>& GetEntries() const { return entries_; };
+    const Entry* GetEntry(const char* name) const;
+    size_t GetSize() const;
+    void Clear();
+
+private:
+    std::map<std::string, Entry> entries_;
+};
+
+} // namespace REx
+
+#endif
@@ -0,0 +1,95 @@
+#include "PathResolver.hh"
+
+#include "TSystem.h"
+
+#include <cctype>
+
+namespace {
+
+bool IsAlnum(char c) {
+    return isalnum((unsigned char)c) != 0;
+}
+
+/// @brief Position of the dot starting the extension (pattern "\.[a-zA-Z0-9]+$"), or -1
+Ssiz_t ExtensionDot(const TString& str) {
+    Ssiz_t s = str.Length() - 1;
+    while (s >= 0 && IsAlnum(str[s]))
+        s--;
+    if (s < 0 || s == str.Length() - 1 || str[s] != '.') return -1;
+    return s;
+}
+
+} // namespace
+
+namespace REx {
+
+PathResolver* PathResolver::GetInstance() {
+    // function-local static : the first call may come from several export threads at once
+    static PathResolver* instance = new PathResolver();
+    return instance;
+}
+
+/// @brief Check if the path ends with a file extension (e.g. ".txt")
+bool PathResolver::HasFileExtension(const TString& path) {
+    return ExtensionDot(path) >= 0;
+}
+
+/// @brief Check if the string is a valid file extension, with or without the leading dot
+bool PathResolver::IsFileExtension(const TString& ext) {
+    Ssiz_t s = ext.BeginsWith(".") ? 1 : 0;
+    if (s >= ext.Length()) return false;
+    for (; s < ext.Length(); s++) {
+        if (!IsAlnum(ext[s])) return false;
+    }
+    return true;
+}
+
+/// @brief Check if the path ends with a file name with an extension (e.g. "file.txt")
+bool PathResolver::IsFileName(const TString& path) {
+    Ssiz_t s = ExtensionDot(path);
+    return s > 0 && IsAlnum(path[s - 1]);
+}
+
+/// @brief Expand shell variables and '~', only if the path contains some
+void PathResolver::ExpandPath(TString& path) {
+    if (path.Contains("$") || path.Contains("~"))
+        gSystem->ExpandPathName(path);
+}
+
+/// @brief Check if a directory exists (a directory is checked only once)
+bool PathResolver::IsDirectory(const TString& dir) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (directories_.count(dir.Data())) return true;
+    if (gSystem->AccessPathName(dir)) return false;
+    directories_.insert(dir.Data());
+    return true;
+}
+
+/// @brief Check if a directory is writable (a directory is checked only once)
+bool PathResolver::IsWritable(const TString& dir) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (writable_.count(dir.Data())) return true;
+    if (gSystem->AccessPathName(dir, EAccessMode::kWritePermission)) return false;
+    writable_.insert(dir.Data());
+    directories_.insert(dir.Data());
+    return true;
+}
+
+/// @brief Create a directory if it does not exist yet (the parent directory must exist)
+/// @return true if the directory exists
+bool PathResolver::MakeDirectory(const TString& dir) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (directories_.count(dir.Data())) return true;
+    if (gSystem->AccessPathName(dir) && gSystem->mkdir(dir) != 0) return false;
+    directories_.insert(dir.Data());
+    return true;
+}
+
+/// @brief Forget the directories already checked (e.g. if some of them were deleted)
+void PathResolver::ClearCache() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    directories_.clear();
+    writable_.clear();
+}
+
+} // namespace REx
@@ -0,0 +1,41 @@
+#ifndef PATHRESOLVER_HH
+#define PATHRESOLVER_HH
+
+#include "TString.h"
+
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace REx {
+
+/// @brief Resolution of output paths, with a cache of the directories already checked or created
+///
+/// The file name patterns are matched without building regular expressions,
+/// and each output directory is checked (or created) only once.
+class PathResolver {
+public:
+    static PathResolver* GetInstance();
+
+    static bool HasFileExtension(const TString& path);
+    static bool IsFileExtension(const TString& ext);
+    static bool IsFileName(const TString& path);
+    static void ExpandPath(TString& path);
+
+    bool IsDirectory(const TString& dir);
+    bool IsWritable(const TString& dir);
+    bool MakeDirectory(const TString& dir);
+    void ClearCache();
+
+private:
+    PathResolver() {};
+
+private:
+    std::mutex mutex_;
+    std::set<std::string> directories_; // existing directories
+    std::set<std::string> writable_;    // directories with write permission
+};
+
+} // namespace REx
+
+#endif
@@ -1,5 +1,7 @@
 #include "ROOTToText.hh"
+#include "DataScan.hh"
 #include "Log.hh"
+#include "PathResolver.hh"
 
 #include "TClass.h"
 #include "TF1.h"
@@ -7,19 +9,47 @@
 #include "TGraph2D.h"
 #include "TGraphErrors.h"
 #include "TH1.h"
+#include "TH1D.h"
 #include "TH2.h"
 #include "THStack.h"
 #include "TMath.h"
 #include "TMultiGraph.h"
 #include "TObjString.h"
-#include "TPRegexp.h"
 #include "TSystem.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <memory>
 
 REx::ROOTToText* gRTT = REx::ROOTToText::GetInstance();
 
+namespace {
+
+/// @brief Stream buffer counting the characters written (nothing is stored)
+class ByteCounter : public std::streambuf {
+public:
+    std::streamsize count = 0;
+
+protected:
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) count++;
+        return traits_type::not_eof(c);
+    }
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        count += n;
+        return n;
+    }
+};
+
+/// @brief Write the points of a graph, in the given order
+void WritePoints(const Double_t* x, const Double_t* y, const std::vector<Int_t>& points, std::ostream& os) {
+    for (Int_t k : points)
+        os << x[k] << " " << y[k] << '\n';
+}
+
+} // namespace
+
 namespace REx {
 
 ROOTToText* ROOTToText::instance_ = 0;
@@ -32,6 +62,7 @@ ROOTToText::ROOTToText() {
     cc_ = '#';
     verb_ = false;
     npfunc_ = 100;
+    sink_ = FileSink::GetInstance();
 }
 
 ROOTToText::~ROOTToText() {
@@ -43,9 +74,14 @@ ROOTToText* ROOTToText::GetInstance() {
     return instance_;
 }
 
+/// @brief Set the destination of the output files (nullptr : files on disk)
+/// @param sink output sink, it is not owned by RTT
+void ROOTToText::SetOutputSink(OutputSink* sink) {
+    sink_ = sink ? sink : FileSink::GetInstance();
+}
+
 void ROOTToText::SetFileExtension(TString ext) {
-    TPRegexp is_ext("^\\.?[a-zA-Z0-9]+$");
-    if (!is_ext.MatchB(ext))
+    if (!PathResolver::IsFileExtension(ext))
         throw std::invalid_argument("this is not a valid file extension");
     defaultExtension_ = ext;
     if (!defaultExtension_.BeginsWith('.'))
@@ -84,8 +120,10 @@ bool ROOTToText::SaveObject(const TObject* obj, DataType dt, TString& filename,
 
     // save collection of objects (TMultiGraph or THStack)
     // we need to perform this test first, because 'filename' is a basename, not a file name
+    // "D" -> force Default writer
+    rtt_writer writer = option.Contains("D") ? nullptr : FindWriter(obj->IsA());
     if (dt == MultiGraph1D || dt == MultiHisto1D) {
-        if (userWriters_.count(obj->IsA()) == 0 || option.Contains("D")) {
+        if (!writer) {
             if (dt == MultiGraph1D)
                 return SaveMultiGraph(dynamic_cast<const TMultiGraph*>(obj), filename, opt);
             else
@@ -94,28 +132,19 @@ bool ROOTToText::SaveObject(const TObject* obj, DataType dt, TString& filename,
     }
 
     TString path = GetFilePath(obj, filename.Data());
-    std::ofstream ofs(path);
-    if (!ofs.is_open()) {
+    std::ofstream ofs;
+    if (!sink_->Open(path, ofs)) {
         LOG_ERROR("Could not open file " << path);
         return false;
     }
 
     bool written = false;
-    // "D" -> force Default writer
-    if (!option.Contains("D")) {
-        auto cl = obj->IsA();
-        if (userWriters_.count(cl)) {
-            try {
-                userWriters_.at(cl)(obj, option, ofs);
-            }
-            catch (const std::exception& e) {
-                std::cerr << "Error when using custom writer for class " << cl->GetName() << std::endl;
-                std::cerr << e.what() << '\n';
-                ofs.close();
-                return false;
-            }
-            written = true;
+    if (writer) {
+        if (!WriteWithCustomWriter(writer, obj, option, ofs)) {
+            sink_->Close(path, ofs, "text/plain");
+            return false;
         }
+        written = true;
     }
 
     if (!written) {
@@ -142,7 +171,10 @@ bool ROOTToText::SaveObject(const TObject* obj, DataType dt, TString& filename,
         }
     }
 
-    ofs.close();
+    if (!sink_->Close(path, ofs, "text/plain")) {
+        LOG_ERROR("Could not write file " << path);
+        return false;
+    }
     if (verb_) LOG_INFO("Saved " << obj->GetName() << " in " << path);
     filename = path;
     return true;
@@ -192,8 +224,7 @@ bool ROOTToText::SaveMultiGraph(const TMultiGraph* mg, TString& filename, Option
         if (basename.IsNull()) basename = "Graph";
     }
     Ssiz_t s = basename.Length();
-    TPRegexp has_ext("\\.[a-zA-Z0-9]+$");
-    if (has_ext.MatchB(basename)) {
+    if (PathResolver::HasFileExtension(basename)) {
         s = basename.Last('.');
     }
 
@@ -231,36 +262,330 @@ bool ROOTToText::SaveHistoStack(const THStack* hs, TString& filename, Option_t*
         if (basename.IsNull()) basename = "Stack";
     }
     Ssiz_t s = basename.Length();
-    TPRegexp has_ext("\\.[a-zA-Z0-9]+$");
-    if (has_ext.MatchB(basename)) {
+    if (PathResolver::HasFileExtension(basename)) {
         s = basename.Last('.');
     }
 
     TString option(opt);
     option.ToUpper();
 
-    TCollection* hlist = nullptr;
-    if (option.Contains("S"))
-        hlist = ((THStack*)hs->Clone())->GetStack();
-    else
-        hlist = hs->GetHists();
+    // stacked histograms are computed on the fly (same result as THStack::GetStack)
+    bool stacked = option.Contains("S");
+    StackedHisto sum;
 
-    TIter it(hlist);
+    TIter it(hs->GetHists());
 
     bool res = true;
-    // loop over all graphs stored in the multigraph, and save them
+    // loop over all histograms stored in the stack, and save them
     while (it.Next()) {
         TString hist_name = (*it)->GetName();
         // set the filename corresponding to this hist
         TString filename_hist(basename);
         filename_hist.Insert(s, "_" + hist_name);
         // save it
-        res = res && SaveObject(*it, Histo1D, filename_hist, opt);
+        if (stacked) {
+            if (!sum.Add(dynamic_cast<const TH1*>(*it))) {
+                LOG_ERROR("Cannot stack histogram " << hist_name << " in " << hs->GetName());
+                return false;
+            }
+            res = res && SaveStackedHisto(sum, filename_hist, option);
+        }
+        else
+            res = res && SaveObject(*it, Histo1D, filename_hist, opt);
     }
     filename = basename;
     return res;
 }
 
+/// @brief Save the points of a graph needed to draw its line at a given resolution (see SelectM4)
+///
+/// The number of points written and the decimation factor are recorded in the header of the file.
+/// A custom writer of the graph class, if any, is used without decimation.
+/// @param gr graph drawn with a line
+/// @param columns pixel columns of the plot and visible x range
+/// @param filename output file name (default: name of the graph)
+/// @param opt option(s), see ROOTToText::PrintOptions()
+/// @return true in case of success
+bool ROOTToText::SaveDecimatedGraph(const TGraph* gr, const PixelColumns& columns, TString& filename, Option_t* opt) const {
+    if (!gr) {
+        LOG_ERROR("null pointer in " << __FUNCTION__);
+        return false;
+    }
+    TString option(opt);
+    option.ToUpper();
+    if (!option.Contains("D") && FindWriter(gr->IsA())) return SaveObject(gr, Graph1D, filename, opt);
+
+    TString path = GetFilePath(gr, filename.Data());
+    std::ofstream ofs;
+    if (!sink_->Open(path, ofs)) {
+        LOG_ERROR("Could not open file " << path);
+        return false;
+    }
+    WriteGraph(gr, option, ofs, &columns);
+    if (!sink_->Close(path, ofs, "text/plain")) {
+        LOG_ERROR("Could not write file " << path);
+        return false;
+    }
+    if (verb_) LOG_INFO("Saved " << gr->GetName() << " in " << path);
+    filename = path;
+    return true;
+}
+
+/// @brief Save a graph as a level-of-detail pyramid: all its points, then successive reductions by 4 (see ReduceM4)
+///
+/// The levels are written from the coarsest one (at most max_points points) to the full data, all sorted by x.
+/// The header lists the levels in the same order, with their reduction factor, number of rows and offset in bytes
+/// from the first data line: "# LOD level <k> factor <4^k> rows <n> offset <bytes>". A reader can load the coarsest
+/// level first, and seek to a finer level when needed. The file is written in binary mode (exact offsets).
+/// A custom writer of the graph class, if any, is used instead (no pyramid).
+/// @param gr graph drawn with a line (the errors are not saved)
+/// @param max_points maximum number of points of the coarsest level
+/// @param filename output file name (default: name of the graph)
+/// @param opt option(s), see ROOTToText::PrintOptions()
+/// @return true in case of success
+bool ROOTToText::SaveGraphPyramid(const TGraph* gr, int max_points, TString& filename, Option_t* opt) const {
+    if (!gr) {
+        LOG_ERROR("null pointer in " << __FUNCTION__);
+        return false;
+    }
+    TString option(opt);
+    option.ToUpper();
+    if (!option.Contains("D") && FindWriter(gr->IsA())) return SaveObject(gr, Graph1D, filename, opt);
+
+    // levels of the pyramid, from the full data (indices of the points sorted by x)
+    const Double_t* XX = gr->GetX();
+    const Double_t* YY = gr->GetY();
+    Int_t np = gr->GetN();
+    std::vector<std::vector<Int_t>> levels(1, std::vector<Int_t>(np));
+    TMath::Sort(np, XX, levels[0].data(), false);
+    while ((int)levels.back().size() > std::max(max_points, 64))
+        levels.push_back(ReduceM4(YY, levels.back()));
+
+    TString path = GetFilePath(gr, filename.Data());
+    std::ofstream ofs;
+    if (!sink_->Open(path, ofs, std::ios_base::out | std::ios_base::binary)) {
+        LOG_ERROR("Could not open file " << path);
+        return false;
+    }
+    WriteGraphHeader(gr, false, false, ofs);
+
+    // offsets of the levels: the coarse ones are formatted once without being stored to get their size
+    const int nlevels = levels.size();
+    std::vector<long long> offsets(nlevels, 0);
+    ByteCounter counter;
+    std::ostream counting(&counter);
+    counting.copyfmt(ofs);
+    for (int k = nlevels - 1; k >= 0; k--) {
+        offsets[k] = counter.count;
+        if (k > 0) WritePoints(XX, YY, levels[k], counting);
+    }
+    ofs << cc_ << " LOD levels " << nlevels << " (coarsest first, offsets in bytes from the first data line)\n";
+    for (int k = nlevels - 1; k >= 0; k--)
+        ofs << cc_ << " LOD level " << k << " factor " << (1LL << (2 * k)) << " rows " << levels[k].size() << " offset " << offsets[k] << '\n';
+    for (int k = nlevels - 1; k >= 0; k--)
+        WritePoints(XX, YY, levels[k], ofs);
+
+    if (!sink_->Close(path, ofs, "text/plain")) {
+        LOG_ERROR("Could not write file " << path);
+        return false;
+    }
+    if (verb_) LOG_INFO("Saved " << gr->GetName() << " (" << nlevels << " levels) in " << path);
+    filename = path;
+    return true;
+}
+
+/// @brief Save one layer of a stack of histograms, i.e. the sum of the histograms up to this layer
+/// @param hs stack of histograms
+/// @param layer index of the last histogram in the sum
+/// @param filename output file name (default: name of the histogram of this layer)
+/// @param opt option(s), see ROOTToText::PrintOptions()
+/// @return true in case of success
+bool ROOTToText::SaveStackLayer(const THStack* hs, int layer, TString& filename, Option_t* opt) const {
+    TString option(opt);
+    option.ToUpper();
+
+    StackedHisto sum;
+    if (!BuildStackLayer(hs, layer, sum)) return false;
+    return SaveStackedHisto(sum, filename, option);
+}
+
+/// @brief Sum the histograms of a stack, up to the given layer
+bool ROOTToText::BuildStackLayer(const THStack* hs, int layer, StackedHisto& sum) const {
+    if (!hs || !hs->GetHists()) {
+        LOG_ERROR("null pointer in " << __FUNCTION__);
+        return false;
+    }
+    if (layer < 0 || layer >= hs->GetHists()->GetSize()) {
+        LOG_ERROR("Layer " << layer << " not found in " << hs->GetName());
+        return false;
+    }
+    TIter it(hs->GetHists());
+    for (int i = 0; i <= layer; i++) {
+        if (!sum.Add(dynamic_cast<const TH1*>(it.Next()))) {
+            LOG_ERROR("Cannot stack histogram " << i << " in " << hs->GetName());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ROOTToText::SaveStackedHisto(const StackedHisto& sum, TString& filename, const TString& option) const {
+    const TH1* h = sum.GetLayer();
+    TString path = GetFilePath(h, filename.Data());
+    std::ofstream ofs;
+    if (!sink_->Open(path, ofs)) {
+        LOG_ERROR("Could not open file " << path);
+        return false;
+    }
+
+    rtt_writer writer = option.Contains("D") ? nullptr : FindWriter(h->IsA());
+    if (writer) {
+        // custom writers expect an object : build a temporary histogram for this layer
+        std::unique_ptr<TH1> hsum(static_cast<TH1*>(h->Clone()));
+        hsum->SetDirectory(nullptr);
+        for (int i = 0; i <= h->GetNbinsX() + 1; i++) {
+            hsum->SetBinContent(i, sum.GetBinContent(i));
+            hsum->SetBinError(i, sum.GetBinError(i));
+        }
+        if (!WriteWithCustomWriter(writer, hsum.get(), option, ofs)) {
+            sink_->Close(path, ofs, "text/plain");
+            return false;
+        }
+    }
+    else {
+        WriteTH1(h, option, ofs, &sum);
+    }
+
+    if (!sink_->Close(path, ofs, "text/plain")) {
+        LOG_ERROR("Could not write file " << path);
+        return false;
+    }
+    if (verb_) LOG_INFO("Saved stacked " << h->GetName() << " in " << path);
+    filename = path;
+    return true;
+}
+
+/// @brief Get the columns of an object in memory, instead of writing them in a file
+///
+/// The columns are the same as in the file written by SaveObject (with the default writer),
+/// e.g. X, Y and EY for a TH1 with option "E".
+/// The values are not copied when they are stored contiguously in the object (see ColumnData).
+/// @param obj object (TH1, TH2, TGraph, TGraph2D or TF1)
+/// @param data output columns (previous columns are cleared)
+/// @param opt option(s), see ROOTToText::PrintOptions()
+/// @return true in case of success
+bool ROOTToText::GetColumns(const TObject* obj, ColumnData& data, Option_t* opt) const {
+    data.Clear();
+    if (!obj) {
+        LOG_ERROR("null pointer in " << __FUNCTION__);
+        return false;
+    }
+
+    TString option(opt);
+    option.ToUpper();
+
+    switch (GetDataType(obj)) {
+        case Histo1D:
+            FillTH1(dynamic_cast<const TH1*>(obj), option, data);
+            break;
+        case Histo2D:
+            FillTH2(dynamic_cast<const TH2*>(obj), option, data);
+            break;
+        case Graph1D:
+            FillGraph(dynamic_cast<const TGraph*>(obj), option, data);
+            break;
+        case Graph2D:
+            FillGraph2D(dynamic_cast<const TGraph2D*>(obj), option, data);
+            break;
+        case Function1D:
+            FillTF1(dynamic_cast<const TF1*>(obj), option, data);
+            break;
+        case MultiHisto1D:
+            LOG_ERROR("Use GetStackLayerColumns to get the columns of " << obj->GetName());
+            return false;
+        default:
+            LOG_ERROR("Cannot get the columns of " << obj->GetName() << " (" << obj->IsA()->GetName() << ")");
+            return false;
+    }
+    return true;
+}
+
+/// @brief Get the columns of one layer of a stack of histograms (sum of the histograms up to this layer)
+/// @param hs stack of histograms
+/// @param layer index of the last histogram in the sum
+/// @param data output columns (previous columns are cleared)
+/// @param opt option(s), see ROOTToText::PrintOptions()
+/// @return true in case of success
+bool ROOTToText::GetStackLayerColumns(const THStack* hs, int layer, ColumnData& data, Option_t* opt) const {
+    data.Clear();
+    TString option(opt);
+    option.ToUpper();
+
+    StackedHisto sum;
+    if (!BuildStackLayer(hs, layer, sum)) return false;
+    FillTH1(sum.GetLayer(), option, data, &sum);
+    return true;
+}
+
+/// @brief Custom writer of a class: the writer of the class itself, or else of its closest registered base class
+///
+/// The result is cached for each class (the cache is cleared when the writers are changed).
+/// @return nullptr if there is no writer for this class
+rtt_writer ROOTToText::FindWriter(const TClass* cl) const {
+    if (!cl) return nullptr;
+    std::lock_guard<std::mutex> lock(writersMutex_);
+    if (userWriters_.empty()) return nullptr;
+    auto it = resolvedWriters_.find(cl);
+    if (it != resolvedWriters_.end()) return it->second;
+
+    rtt_writer writer = nullptr;
+    const TClass* base = nullptr;
+    for (const auto& w : userWriters_) {
+        if (!cl->InheritsFrom(w.first)) continue;
+        if (!base || w.first->InheritsFrom(base)) {
+            base = w.first;
+            writer = w.second;
+        }
+    }
+    resolvedWriters_.emplace(cl, writer);
+    return writer;
+}
+
+bool ROOTToText::WriteWithCustomWriter(rtt_writer writer, const TObject* obj, const TString& option, std::ofstream& ofs) const {
+    auto cl = obj->IsA();
+    try {
+        writer(obj, option, ofs);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error when using custom writer for class " << cl->GetName() << std::endl;
+        std::cerr << e.what() << '\n';
+        return false;
+    }
+    return true;
+}
+
+/// @brief Add the next histogram of the stack to the sum
+/// @return false if the histogram is not compatible with the previous ones
+bool StackedHisto::Add(const TH1* h) {
+    if (!h) return false;
+    int nbins = h->GetNbinsX() + 2; // with underflow and overflow bins
+    if (!layer_) {
+        sum_.assign(nbins, 0.);
+        err2_.assign(nbins, 0.);
+    }
+    else if ((int)sum_.size() != nbins) {
+        return false;
+    }
+    for (int i = 0; i < nbins; i++) {
+        Double_t e = h->GetBinError(i);
+        sum_[i] += h->GetBinContent(i);
+        err2_[i] += e * e;
+    }
+    if (h->GetSumw2N()) sumw2_ = true;
+    layer_ = h;
+    return true;
+}
+
 bool ROOTToText::AddCustomWriter(const char* class_name, rtt_writer& func) {
     auto cl = TClass::GetClass(class_name);
     if (!cl) {
@@ -271,16 +596,20 @@ bool ROOTToText::AddCustomWriter(const char* class_name, rtt_writer& func) {
         LOG_ERROR("Class " << class_name << " does not inherit from TObject.");
         return false;
     }
+    std::lock_guard<std::mutex> lock(writersMutex_);
     if (userWriters_.count(cl))
         LOG_WARN("Overwritting writer function for class " << class_name);
     userWriters_[cl] = func;
+    resolvedWriters_.clear();
     return true;
 }
 
 bool ROOTToText::RemoveCustomWriter(const char* class_name) {
     auto cl = TClass::GetClass(class_name);
+    std::lock_guard<std::mutex> lock(writersMutex_);
     if (userWriters_.count(cl)) {
         userWriters_.erase(cl);
+        resolvedWriters_.clear();
         return true;
     }
     else {
@@ -290,7 +619,9 @@ bool ROOTToText::RemoveCustomWriter(const char* class_name) {
 }
 
 void ROOTToText::ClearCustomWriters() {
+    std::lock_guard<std::mutex> lock(writersMutex_);
     userWriters_.clear();
+    resolvedWriters_.clear();
 }
 
 void ROOTToText::SetDirectory(TString dir) {
@@ -303,29 +634,29 @@ void ROOTToText::SetDirectory(TString dir) {
         return;
     }
 
-    TPRegexp is_file("[a-zA-Z0-9]+\\.[a-zA-Z0-9]+$");
-    if (is_file.MatchB(path)) {
+    if (PathResolver::IsFileName(path)) {
         // this path is a file !
         throw std::invalid_argument("this is not a directory");
     }
 
-    gSystem->ExpandPathName(path); // remove symbols
+    PathResolver::ExpandPath(path); // remove symbols
     if (!gSystem->IsAbsoluteFileName(path) && !path.BeginsWith("./")) {
         // relative directory... to what ?
         // let's assume its relative to current dir
         gSystem->PrependPathName("./", path);
     }
 
-    if (!gSystem->AccessPathName(path)) {
+    // directories are checked only once (ExPad sets and restores the directory for each plot)
+    if (sink_->IsDirectory(path)) {
         // this path exists
         baseDirectory_ = path;
         return;
     }
 
-    if (!gSystem->AccessPathName(gSystem->DirName(path))) {
+    if (sink_->IsDirectory(gSystem->DirName(path))) {
         // parent directory exists
         // we try to make the desired directory
-        if (gSystem->mkdir(path) == 0) {
+        if (sink_->MakeDirectory(path)) {
             baseDirectory_ = path;
             return;
         }
@@ -338,22 +669,24 @@ void ROOTToText::SetDirectory(TString dir) {
     // std::cerr << "Keeping the previous directory: " << baseDirectory_ << std::endl;
 }
 
+/// @brief Full path of an output file: default directory and extension are added if needed
+/// @param obj object to save (its name is used if no filename is given)
+/// @param filename output file name
 TString ROOTToText::GetFilePath(const TObject* obj, const char* filename) const {
     TString str(filename);
 
     // if no filename is given, use the object name
-    if (str.IsWhitespace()) {
+    if (str.IsWhitespace() && obj) {
         str = obj->GetName();
         str.ReplaceAll(' ', '_');
     }
 
     // check that filename ends with a file extension
     // if not, add the default extension
-    TPRegexp fileExt("\\.[a-zA-Z0-9]+$");
-    if (!fileExt.MatchB(str))
+    if (!PathResolver::HasFileExtension(str))
         str.Append(defaultExtension_);
 
-    gSystem->ExpandPathName(str);
+    PathResolver::ExpandPath(str);
     if (!gSystem->IsAbsoluteFileName(str) && !str.BeginsWith("./")) {
         gSystem->PrependPathName(baseDirectory_, str);
     }
@@ -361,7 +694,9 @@ TString ROOTToText::GetFilePath(const TObject* obj, const char* filename) const
     return str;
 }
 
-void ROOTToText::WriteTH1(const TH1* h, const TString& option, std::ofstream& ofs) const {
+/// @brief Write a 1D histogram
+/// @param sum if given, the bin contents and errors are taken from this sum (stacked histograms)
+void ROOTToText::WriteTH1(const TH1* h, const TString& option, std::ofstream& ofs, const StackedHisto* sum) const {
     bool low_edge = option.Contains('L');
     bool with_errors = option.Contains('E');
     bool use_range = option.Contains('R');
@@ -394,9 +729,9 @@ void ROOTToText::WriteTH1(const TH1* h, const TString& option, std::ofstream& of
             ofs << h->GetBinLowEdge(i);
         else
             ofs << h->GetBinCenter(i);
-        ofs << " " << h->GetBinContent(i);
+        ofs << " " << (sum ? sum->GetBinContent(i) : h->GetBinContent(i));
         if (with_errors)
-            ofs << " " << h->GetBinError(i);
+            ofs << " " << (sum ? sum->GetBinError(i) : h->GetBinError(i));
         ofs << std::endl;
     }
 }
@@ -485,7 +820,7 @@ void ROOTToText::WriteTH2(const TH2* h, const TString& option, std::ofstream& of
     }
 }
 
-void ROOTToText::WriteGraph(const TGraph* gr, const TString& option, std::ofstream& ofs) const {
+void ROOTToText::WriteGraph(const TGraph* gr, const TString& option, std::ofstream& ofs, const PixelColumns* columns) const {
     if (gr->IsA() != TGraph::Class() && gr->IsA() != TGraphErrors::Class())
         LOG_WARN("Only limited support for class " << gr->IsA()->GetName());
 
@@ -498,7 +833,33 @@ void ROOTToText::WriteGraph(const TGraph* gr, const TString& option, std::ofstre
     Double_t* EY = gr->GetEY();
     if (!EY) with_errors = with_herrors = false;
     if (!EX) with_herrors = false;
+    WriteGraphHeader(gr, with_errors, with_herrors, ofs);
+
+    Int_t np = gr->GetN();
+    std::vector<Int_t> idx(np);
+    TMath::Sort(np, XX, idx.data(), false);
+    if (columns) {
+        // keep the points drawn at this resolution
+        idx = SelectM4(XX, YY, idx.data(), np, *columns);
+        if ((int)idx.size() < np)
+            ofs << cc_ << " M4 decimation: " << idx.size() << " of " << np << " points (factor " << (double)np / std::max<size_t>(idx.size(), 1)
+                << "), " << columns->n << " pixel columns in [" << columns->xmin << ", " << columns->xmax << "]" << std::endl;
+    }
+
+    for (Int_t k : idx) {
+        ofs << XX[k] << " " << YY[k];
+        if (with_errors) {
+            if (with_herrors)
+                ofs << " " << EX[k] << " " << EY[k];
+            else
+                ofs << " " << EY[k];
+        }
+        ofs << std::endl;
+    }
+}
 
+/// @brief Title and columns of a graph, in comment lines
+void ROOTToText::WriteGraphHeader(const TGraph* gr, bool with_errors, bool with_herrors, std::ofstream& ofs) const {
     if (headerTitle_)
         ofs << cc_ << " " << gr->GetTitle() << std::endl;
 
@@ -521,23 +882,6 @@ void ROOTToText::WriteGraph(const TGraph* gr, const TString& option, std::ofstre
                 ofs << cc_ << " 3:EY" << std::endl;
         }
     }
-
-    Int_t np = gr->GetN();
-    Int_t* idx = new Int_t[np];
-    TMath::Sort(np, XX, idx, false);
-
-    for (int i = 0; i < np; i++) {
-        Int_t k = idx[i];
-        ofs << XX[k] << " " << YY[k];
-        if (with_errors) {
-            if (with_herrors)
-                ofs << " " << EX[k] << " " << EY[k];
-            else
-                ofs << " " << EY[k];
-        }
-        ofs << std::endl;
-    }
-    delete[] idx;
 }
 
 void ROOTToText::WriteGraph2D(const TGraph2D* gr, const TString& /*option*/, std::ofstream& ofs) const {
@@ -578,8 +922,8 @@ void ROOTToText::WriteGraph2D(const TGraph2D* gr, const TString& /*option*/, std
     delete[] idx;
 }
 
-void ROOTToText::WriteTF1(const TF1* f, const TString& option, std::ofstream& ofs) const {
-    // number of points for evaluation
+/// @brief Number of points to evaluate a function (option N<n>, or default number of points)
+int ROOTToText::GetNpFunction(const TString& option) const {
     int npoints = -1;
     if (option.Contains("N")) {
         auto s1 = option.First('N');
@@ -590,7 +934,12 @@ void ROOTToText::WriteTF1(const TF1* f, const TString& option, std::ofstream& of
         if (!sub.IsNull())
             npoints = sub.Atoi();
     }
-    if (npoints <= 0) npoints = npfunc_;
+    return npoints > 0 ? npoints : npfunc_;
+}
+
+void ROOTToText::WriteTF1(const TF1* f, const TString& option, std::ofstream& ofs) const {
+    // number of points for evaluation
+    int npoints = GetNpFunction(option);
 
     // function range
     Double_t xmin, xmax;
@@ -611,4 +960,147 @@ void ROOTToText::WriteTF1(const TF1* f, const TString& option, std::ofstream& of
     }
 }
 
+
+/// @brief Columns of a 1D histogram (X, Y and EY with option E)
+/// @param sum if given, the bin contents and errors are taken from this sum (stacked histograms)
+void ROOTToText::FillTH1(const TH1* h, const TString& option, ColumnData& data, const StackedHisto* sum) const {
+    bool low_edge = option.Contains('L');
+    bool with_errors = option.Contains('E');
+    bool use_range = option.Contains('R');
+
+    int imin = 1, imax = h->GetNbinsX();
+    if (use_range) {
+        imin = h->GetXaxis()->GetFirst();
+        imax = h->GetXaxis()->GetLast();
+    }
+    size_t n = imax >= imin ? imax - imin + 1 : 0;
+
+    // X : the low edges of variable size bins are stored in the axis
+    const TArrayD* xbins = h->GetXaxis()->GetXbins();
+    if (low_edge && h->GetXaxis()->IsVariableBinSize() && xbins && xbins->GetSize() > imax)
+        data.AddView("X", xbins->GetArray() + imin - 1, n);
+    else {
+        Double_t* x = data.AddColumn("X", n);
+        for (int i = imin; i <= imax; i++)
+            x[i - imin] = low_edge ? h->GetBinLowEdge(i) : h->GetBinCenter(i);
+    }
+
+    // Y : the contents of a TH1D are stored in a contiguous array (index 0 is the underflow bin)
+    if (sum)
+        std::copy(sum->GetArray() + imin, sum->GetArray() + imin + n, data.AddColumn("Y", n));
+    else if (h->IsA() == TH1D::Class())
+        data.AddView("Y", dynamic_cast<const TArrayD*>(h)->GetArray() + imin, n);
+    else {
+        Double_t* y = data.AddColumn("Y", n);
+        for (int i = imin; i <= imax; i++)
+            y[i - imin] = h->GetBinContent(i);
+    }
+
+    if (with_errors) {
+        Double_t* ey = data.AddColumn("EY", n);
+        for (int i = imin; i <= imax; i++)
+            ey[i - imin] = sum ? sum->GetBinError(i) : h->GetBinError(i);
+    }
+}
+
+/// @brief Columns of a 2D histogram (X, Y, Z), as written with option C
+void ROOTToText::FillTH2(const TH2* h, const TString& option, ColumnData& data) const {
+    bool use_range = option.Contains('R');
+    int imin = 1, imax = h->GetNbinsX();
+    int jmin = 1, jmax = h->GetNbinsY();
+    if (use_range) {
+        imin = h->GetXaxis()->GetFirst();
+        imax = h->GetXaxis()->GetLast();
+        jmin = h->GetYaxis()->GetFirst();
+        jmax = h->GetYaxis()->GetLast();
+    }
+    size_t nx = imax >= imin ? imax - imin + 1 : 0;
+    size_t ny = jmax >= jmin ? jmax - jmin + 1 : 0;
+    Double_t* x = data.AddColumn("X", nx * ny);
+    Double_t* y = data.AddColumn("Y", nx * ny);
+    Double_t* z = data.AddColumn("Z", nx * ny);
+    size_t k = 0;
+    for (int i = imin; i <= imax; i++) {
+        for (int j = jmin; j <= jmax; j++, k++) {
+            x[k] = h->GetXaxis()->GetBinCenter(i);
+            y[k] = h->GetYaxis()->GetBinCenter(j);
+            z[k] = h->GetBinContent(i, j);
+        }
+    }
+}
+
+/// @brief Columns of a graph (X, Y, EY and EX with option H), sorted by X
+void ROOTToText::FillGraph(const TGraph* gr, const TString& option, ColumnData& data) const {
+    bool with_errors = true;
+    bool with_herrors = option.Contains("H");
+
+    const Double_t* XX = gr->GetX();
+    const Double_t* YY = gr->GetY();
+    const Double_t* EX = gr->GetEX();
+    const Double_t* EY = gr->GetEY();
+    if (!EY) with_errors = with_herrors = false;
+    if (!EX) with_herrors = false;
+
+    Int_t np = gr->GetN();
+    if (ScanData(XX, np).increasing) {
+        // already sorted : no copy
+        data.AddView("X", XX, np);
+        data.AddView("Y", YY, np);
+        if (with_herrors) data.AddView("EX", EX, np);
+        if (with_errors) data.AddView("EY", EY, np);
+        return;
+    }
+
+    std::vector<Int_t> idx(np);
+    TMath::Sort(np, XX, idx.data(), false);
+    auto add_sorted = [&](const char* name, const Double_t* values) {
+        Double_t* col = data.AddColumn(name, np);
+        for (int i = 0; i < np; i++)
+            col[i] = values[idx[i]];
+    };
+    add_sorted("X", XX);
+    add_sorted("Y", YY);
+    if (with_herrors) add_sorted("EX", EX);
+    if (with_errors) add_sorted("EY", EY);
+}
+
+/// @brief Columns of a 2D graph (X, Y, Z), sorted by X
+void ROOTToText::FillGraph2D(const TGraph2D* gr, const TString& /*option*/, ColumnData& data) const {
+    const Double_t* XX = gr->GetX();
+    const Double_t* YY = gr->GetY();
+    const Double_t* ZZ = gr->GetZ();
+    Int_t np = gr->GetN();
+    if (ScanData(XX, np).increasing) {
+        data.AddView("X", XX, np);
+        data.AddView("Y", YY, np);
+        data.AddView("Z", ZZ, np);
+        return;
+    }
+
+    std::vector<Int_t> idx(np);
+    TMath::Sort(np, XX, idx.data(), false);
+    Double_t* x = data.AddColumn("X", np);
+    Double_t* y = data.AddColumn("Y", np);
+    Double_t* z = data.AddColumn("Z", np);
+    for (int i = 0; i < np; i++) {
+        x[i] = XX[idx[i]];
+        y[i] = YY[idx[i]];
+        z[i] = ZZ[idx[i]];
+    }
+}
+
+/// @brief Columns of a function (X, Y), evaluated on N<n> points
+void ROOTToText::FillTF1(const TF1* f, const TString& option, ColumnData& data) const {
+    int npoints = GetNpFunction(option);
+    Double_t xmin, xmax;
+    f->GetRange(xmin, xmax);
+    Double_t* x = data.AddColumn("X", npoints);
+    Double_t* y = data.AddColumn("Y", npoints);
+    double dx = (xmax - xmin) / ((double)npoints - 1);
+    for (int i = 0; i < npoints; i++) {
+        x[i] = xmin + dx * i;
+        y[i] = f->Eval(x[i]);
+    }
+}
+
 } // namespace REx
@@ -4,9 +4,16 @@
 #include "TROOT.h"
 #include "TString.h"
 
+#include "ColumnData.hh"
 #include "DataType.hh"
+#include "Decimation.hh"
+#include "OutputSink.hh"
 
+#include <cmath>
 #include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 class TH1;
 class TH2;
@@ -24,6 +31,26 @@ namespace REx {
 // This is not the most convenient way, but it is a more straightforward approach than using templates
 typedef void (*rtt_writer)(const TObject* obj, const TString& option, std::ofstream& ofs);
 
+/// @brief Running bin-by-bin sum of the histograms of a THStack
+///
+/// After adding the n first histograms of the stack, it holds the same contents and errors
+/// as the n-th histogram from THStack::GetStack(), without building any temporary histogram.
+class StackedHisto {
+public:
+    bool Add(const TH1* h);
+    inline const TH1* GetLayer() const;
+    inline Double_t GetBinContent(int i) const;
+    inline Double_t GetBinError(int i) const;
+    inline const Double_t* GetArray() const;
+    inline bool HasSumw2() const;
+
+private:
+    const TH1* layer_ = nullptr; // last histogram added to the sum
+    bool sumw2_ = false;
+    std::vector<Double_t> sum_;
+    std::vector<Double_t> err2_; // sum of squared errors
+};
+
 // using writer = std::function<void(const TObject* obj, const TString& option, std::ofstream& ofs)>; // not compatible with my old ROOT5 + MSVC 12.0 config
 
 class ROOTToText {
@@ -33,6 +60,8 @@ public:
     static ROOTToText* GetInstance();
 
     inline void SetHeader(bool title = true, bool axis = true);
+    inline bool GetHeaderTitle() const;
+    inline bool GetHeaderAxis() const;
     void SetFileExtension(TString ext);
     void SetDirectory(TString dir);
     inline void SetCommentChar(char c);
@@ -42,6 +71,8 @@ public:
     inline void SetVerbose(bool v);
     inline bool GetVerbose() const;
     inline void SetDefaultNpFunction(int n);
+    void SetOutputSink(OutputSink* sink);
+    inline OutputSink* GetOutputSink() const;
     // set precision, format ?
     bool AddCustomWriter(const char* class_name, rtt_writer& func);
     bool RemoveCustomWriter(const char* class_name);
@@ -50,21 +81,38 @@ public:
     bool SaveObject(const TObject* obj, const char* filename = "", Option_t* opt = "") const;
     bool SaveObject(const TObject* obj, DataType dt, const char* filename = "", Option_t* opt = "") const;
     bool SaveObject(const TObject* obj, DataType dt, TString& filename, Option_t* opt = "") const;
+    bool SaveStackLayer(const THStack* hs, int layer, TString& filename, Option_t* opt = "") const;
+    bool SaveDecimatedGraph(const TGraph* gr, const PixelColumns& columns, TString& filename, Option_t* opt = "") const;
+    bool SaveGraphPyramid(const TGraph* gr, int max_points, TString& filename, Option_t* opt = "") const;
+    bool GetColumns(const TObject* obj, ColumnData& data, Option_t* opt = "") const;
+    bool GetStackLayerColumns(const THStack* hs, int layer, ColumnData& data, Option_t* opt = "") const;
     void PrintOptions() const;
+    TString GetFilePath(const TObject* obj, const char* filename) const;
 
 private:
     ROOTToText();
-    TString GetFilePath(const TObject* obj, const char* filename) const;
 
     bool SaveMultiGraph(const TMultiGraph* mg, TString& filename, Option_t* opt = "") const;
     bool SaveHistoStack(const THStack* hs, TString& filename, Option_t* opt = "") const;
+    bool SaveStackedHisto(const StackedHisto& sum, TString& filename, const TString& option) const;
+    rtt_writer FindWriter(const TClass* cl) const;
+    bool WriteWithCustomWriter(rtt_writer writer, const TObject* obj, const TString& option, std::ofstream& ofs) const;
+    bool BuildStackLayer(const THStack* hs, int layer, StackedHisto& sum) const;
+    int GetNpFunction(const TString& option) const;
 
-    void WriteTH1(const TH1* h, const TString& option, std::ofstream& ofs) const;
+    void WriteTH1(const TH1* h, const TString& option, std::ofstream& ofs, const StackedHisto* sum = nullptr) const;
     void WriteTH2(const TH2* h, const TString& option, std::ofstream& ofs) const;
-    void WriteGraph(const TGraph* gr, const TString& option, std::ofstream& ofs) const;
+    void WriteGraph(const TGraph* gr, const TString& option, std::ofstream& ofs, const PixelColumns* columns = nullptr) const;
+    void WriteGraphHeader(const TGraph* gr, bool with_errors, bool with_herrors, std::ofstream& ofs) const;
     void WriteGraph2D(const TGraph2D* gr, const TString& option, std::ofstream& ofs) const;
     void WriteTF1(const TF1* f, const TString& option, std::ofstream& ofs) const;
 
+    void FillTH1(const TH1* h, const TString& option, ColumnData& data, const StackedHisto* sum = nullptr) const;
+    void FillTH2(const TH2* h, const TString& option, ColumnData& data) const;
+    void FillGraph(const TGraph* gr, const TString& option, ColumnData& data) const;
+    void FillGraph2D(const TGraph2D* gr, const TString& option, ColumnData& data) const;
+    void FillTF1(const TF1* f, const TString& option, ColumnData& data) const;
+
 private:
     bool headerTitle_ = true;
     bool headerAxis_ = true;
@@ -74,9 +122,34 @@ private:
     char cc_;    // comment character
     bool verb_;  // verbose
     int npfunc_; // default number of points for functions (TF1)
+    OutputSink* sink_; // destination of the files (not owned)
     std::map<TClass*, rtt_writer> userWriters_;
+    mutable std::unordered_map<const TClass*, rtt_writer> resolvedWriters_; // writer of each class (nullptr: none)
+    mutable std::mutex writersMutex_;                                       // userWriters_ and resolvedWriters_ (export threads)
 };
 
+const TH1* StackedHisto::GetLayer() const {
+    return layer_;
+}
+
+Double_t StackedHisto::GetBinContent(int i) const {
+    return sum_[i];
+}
+
+Double_t StackedHisto::GetBinError(int i) const {
+    return std::sqrt(err2_[i]);
+}
+
+/// @brief Bin contents, including underflow (index 0) and overflow bins
+const Double_t* StackedHisto::GetArray() const {
+    return sum_.data();
+}
+
+/// @brief True if at least one of the stacked histograms stores the sum of squares of weights
+bool StackedHisto::HasSumw2() const {
+    return sumw2_;
+}
+
 /// @brief Setup the default header content
 /// @param title Print object title in header
 /// @param axis Print axis titles in header
@@ -85,6 +158,14 @@ void ROOTToText::SetHeader(bool title, bool axis) {
     headerAxis_ = axis;
 }
 
+bool ROOTToText::GetHeaderTitle() const {
+    return headerTitle_;
+}
+
+bool ROOTToText::GetHeaderAxis() const {
+    return headerAxis_;
+}
+
 TString ROOTToText::GetFileExtension() const {
     return defaultExtension_;
 }
@@ -109,6 +190,10 @@ bool ROOTToText::GetVerbose() const {
     return verb_;
 }
 
+OutputSink* ROOTToText::GetOutputSink() const {
+    return sink_;
+}
+
 /// @brief Set the default number of points to use when saving a TF1
 /// @param n number of points
 inline void ROOTToText::SetDefaultNpFunction(int n) {
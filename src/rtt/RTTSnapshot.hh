@@ -0,0 +1,231 @@
+#ifndef RTTSNAPSHOT_HH
+#define RTTSNAPSHOT_HH
+
+#include "RVersion.h"
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 22, 0)
+
+#include "ROOTToText.hh"
+
+#include "ROOT/RDF/RActionImpl.hxx"
+#include "ROOT/RDataFrame.hxx"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+class TTreeReader;
+
+namespace REx {
+
+namespace Internal {
+
+template <typename... Ts>
+struct AllArithmetic : std::true_type {};
+
+template <typename T, typename... Ts>
+struct AllArithmetic<T, Ts...> : std::integral_constant<bool, std::is_arithmetic<T>::value && AllArithmetic<Ts...>::value> {};
+
+} // namespace Internal
+
+/// @brief RDataFrame action writing columns in a file, with the RTT conventions (directory, extension, header, output sink)
+///
+/// The rows are formatted in parallel, in one buffer per processing slot, and merged when the event loop ends.
+/// The first column of the action must be the entry number ("rdfentry_"), which is used to restore the entry order;
+/// use the REx::RTTSnapshot function to book it (it also sets the number of slots from the data frame).
+///
+/// | Option | Description                                                               |
+/// |--------|---------------------------------------------------------------------------|
+/// | U      | Unordered: the rows are written as soon as possible, in any order         |
+/// | B      | Binary: the values are written as native doubles (row-major), no header   |
+///
+/// In the ordered mode (default), all the rows are kept in memory until the end of the event loop.
+template <typename... ColumnTypes>
+class RTTSnapshotHelper : public ROOT::Detail::RDF::RActionImpl<RTTSnapshotHelper<ColumnTypes...>> {
+public:
+    using Result_t = ULong64_t; // number of rows written
+
+    RTTSnapshotHelper(const char* filename, const std::vector<std::string>& columns, unsigned int nslots, Option_t* opt = "", const char* title = "");
+    RTTSnapshotHelper(RTTSnapshotHelper&&) = default;
+    RTTSnapshotHelper(const RTTSnapshotHelper&) = delete;
+
+    std::shared_ptr<Result_t> GetResultPtr() const { return result_; };
+    void Initialize();
+    void InitTask(TTreeReader*, unsigned int) {};
+    void Exec(unsigned int slot, ULong64_t entry, const ColumnTypes&... values);
+    void Finalize();
+    std::string GetActionName() { return "RTTSnapshot"; };
+
+private:
+    // rows of consecutive entries
+    struct Chunk {
+        ULong64_t first;
+        ULong64_t next;
+        std::string data;
+    };
+
+    struct Slot {
+        std::ostringstream os; // current chunk
+        std::vector<Chunk> chunks;
+        ULong64_t rows = 0;
+    };
+
+    void WriteHeader();
+    void FlushSlot(Slot& s, bool force);
+
+    template <typename T>
+    static typename std::enable_if<std::is_arithmetic<T>::value>::type WriteBinary(std::ostream& os, const T& value) {
+        double d = value;
+        os.write(reinterpret_cast<const char*>(&d), sizeof(d));
+    };
+    template <typename T>
+    static typename std::enable_if<!std::is_arithmetic<T>::value>::type WriteBinary(std::ostream&, const T&) {};
+
+private:
+    TString filename_;
+    TString title_;
+    std::vector<std::string> columns_;
+    bool ordered_;
+    bool binary_;
+    TString path_;
+    OutputSink* sink_;
+    std::unique_ptr<std::ofstream> ofs_;
+    std::unique_ptr<std::mutex> mutex_; // protects ofs_ in the unordered mode
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::shared_ptr<Result_t> result_;
+    static const size_t kFlushSize = 1 << 20; // unordered mode: size of a slot buffer before writing it
+};
+
+/// @param nslots number of processing slots of the data frame (RInterface::GetNSlots)
+template <typename... ColumnTypes>
+RTTSnapshotHelper<ColumnTypes...>::RTTSnapshotHelper(const char* filename, const std::vector<std::string>& columns, unsigned int nslots, Option_t* opt, const char* title)
+    : filename_(filename), title_(title), columns_(columns), sink_(nullptr), mutex_(new std::mutex), result_(std::make_shared<Result_t>(0)) {
+    if (columns_.size() != sizeof...(ColumnTypes))
+        throw std::invalid_argument("the number of columns does not match the number of column types");
+    if (!nslots)
+        throw std::invalid_argument("the number of slots must be positive");
+    TString option(opt);
+    option.ToUpper();
+    ordered_ = !option.Contains("U");
+    binary_ = option.Contains("B");
+    if (binary_ && !Internal::AllArithmetic<ColumnTypes...>::value)
+        throw std::invalid_argument("binary output requires arithmetic columns");
+
+    for (unsigned int i = 0; i < nslots; i++)
+        slots_.emplace_back(new Slot());
+}
+
+/// @brief Open the output file (through the RTT output sink) and write the header
+template <typename... ColumnTypes>
+void RTTSnapshotHelper<ColumnTypes...>::Initialize() {
+    path_ = gRTT->GetFilePath(nullptr, filename_.IsWhitespace() ? "snapshot" : filename_.Data());
+    sink_ = gRTT->GetOutputSink();
+    ofs_.reset(new std::ofstream());
+    std::ios_base::openmode mode = binary_ ? std::ios_base::out | std::ios_base::binary : std::ios_base::out;
+    if (!sink_->Open(path_, *ofs_, mode)) {
+        TString error_msg = "file " + path_ + " cannot be opened.";
+        throw std::runtime_error(error_msg.Data());
+    }
+    if (!binary_) WriteHeader();
+}
+
+/// @brief Same header as the RTT writers: title, then one line per column
+template <typename... ColumnTypes>
+void RTTSnapshotHelper<ColumnTypes...>::WriteHeader() {
+    char cc = gRTT->GetCommentChar();
+    if (gRTT->GetHeaderTitle() && title_.Length() > 0)
+        *ofs_ << cc << " " << title_ << std::endl;
+    if (gRTT->GetHeaderAxis()) {
+        for (size_t i = 0; i < columns_.size(); i++)
+            *ofs_ << cc << " " << i + 1 << ":" << columns_[i] << std::endl;
+    }
+}
+
+template <typename... ColumnTypes>
+void RTTSnapshotHelper<ColumnTypes...>::Exec(unsigned int slot, ULong64_t entry, const ColumnTypes&... values) {
+    Slot& s = *slots_[slot];
+    if (ordered_) {
+        // a new chunk starts when the entries are not consecutive
+        if (s.chunks.empty() || s.chunks.back().next != entry) {
+            FlushSlot(s, false);
+            s.chunks.push_back({entry, entry + 1, std::string()});
+        }
+        else
+            s.chunks.back().next = entry + 1;
+    }
+
+    if (binary_) {
+        int expand[] = {0, (WriteBinary(s.os, values), 0)...};
+        (void)expand;
+    }
+    else {
+        int col = 0;
+        int expand[] = {0, ((col++ ? s.os << " " << values : s.os << values), 0)...};
+        (void)expand;
+        s.os << '\n';
+    }
+    s.rows++;
+
+    if (!ordered_ && (size_t)s.os.tellp() > kFlushSize)
+        FlushSlot(s, true);
+}
+
+/// @brief Move the content of the slot buffer to the current chunk (ordered mode) or to the file (unordered mode)
+template <typename... ColumnTypes>
+void RTTSnapshotHelper<ColumnTypes...>::FlushSlot(Slot& s, bool force) {
+    if (ordered_) {
+        if (!s.chunks.empty())
+            s.chunks.back().data = s.os.str();
+    }
+    else if (force) {
+        std::lock_guard<std::mutex> lock(*mutex_);
+        *ofs_ << s.os.str();
+    }
+    s.os.str("");
+}
+
+/// @brief Write the remaining rows (in entry order, if ordered) and close the file
+template <typename... ColumnTypes>
+void RTTSnapshotHelper<ColumnTypes...>::Finalize() {
+    std::vector<Chunk*> chunks;
+    for (auto& s : slots_) {
+        FlushSlot(*s, true);
+        for (auto& c : s->chunks)
+            chunks.push_back(&c);
+        *result_ += s->rows;
+    }
+    std::sort(chunks.begin(), chunks.end(), [](const Chunk* a, const Chunk* b) { return a->first < b->first; });
+    for (auto c : chunks) {
+        ofs_->write(c->data.data(), c->data.size());
+        std::string().swap(c->data);
+    }
+    if (!sink_->Close(path_, *ofs_, binary_ ? "application/octet-stream" : "text/plain")) {
+        TString error_msg = "file " + path_ + " could not be written.";
+        throw std::runtime_error(error_msg.Data());
+    }
+}
+
+/// @brief Book a RTTSnapshotHelper action on a RDataFrame node
+/// @param df RDataFrame node
+/// @param filename output file name (RTT directory and extension are added if needed)
+/// @param columns names of the columns to write
+/// @param opt option(s), see RTTSnapshotHelper
+/// @param title title written in the header
+/// @return number of rows written (lazy result)
+template <typename... ColumnTypes, typename Node>
+ROOT::RDF::RResultPtr<ULong64_t> RTTSnapshot(Node& df, const char* filename, const std::vector<std::string>& columns, Option_t* opt = "", const char* title = "") {
+    std::vector<std::string> action_columns{"rdfentry_"};
+    action_columns.insert(action_columns.end(), columns.begin(), columns.end());
+    return df.template Book<ULong64_t, ColumnTypes...>(RTTSnapshotHelper<ColumnTypes...>(filename, columns, df.GetNSlots(), opt, title), action_columns);
+}
+
+} // namespace REx
+
+#endif // ROOT_VERSION_CODE
+
+#endif
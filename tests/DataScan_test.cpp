@@ -0,0 +1,55 @@
+#include "DataScan_test.hh"
+#include "DataScan.hh"
+#include "macros.hh"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+void TestDataScan() {
+    BEGIN_TEST();
+    std::cout << "Data scan kernel: " << REx::GetScanKernelName() << std::endl;
+
+    // empty column
+    auto s0 = REx::ScanData(nullptr, 0);
+    SIMPLE_TEST(s0.n == 0);
+    SIMPLE_TEST(s0.allZero);
+    SIMPLE_TEST(!s0.HasFinite());
+
+    // zeros (odd size to test the remainder of the vectorized loop)
+    std::vector<double> zeros(13, 0.);
+    auto sz = REx::ScanData(zeros.data(), zeros.size());
+    SIMPLE_TEST(sz.allZero);
+    SIMPLE_TEST(sz.increasing && sz.decreasing);
+    SIMPLE_TEST(sz.integer);
+    SIMPLE_TEST(sz.min == 0 && sz.max == 0);
+    SIMPLE_TEST(sz.minPositive > sz.max);
+
+    // increasing integers
+    std::vector<double> xx;
+    for (int i = -5; i < 16; i++)
+        xx.push_back(i);
+    auto sx = REx::ScanData(xx.data(), xx.size());
+    SIMPLE_TEST(sx.n == 21);
+    SIMPLE_TEST(!sx.allZero);
+    SIMPLE_TEST(sx.increasing && !sx.decreasing);
+    SIMPLE_TEST(sx.integer);
+    SIMPLE_TEST(sx.min == -5 && sx.max == 15 && sx.minPositive == 1);
+    SIMPLE_TEST(!sx.hasNaN && !sx.hasInf);
+
+    // non-monotonic with NaN, inf and fractional values (extrema are in the remainder)
+    std::vector<double> yy = {3.5, 2, 7, 1, 0.25, std::numeric_limits<double>::quiet_NaN(), 4, 1, -std::numeric_limits<double>::infinity(), -2.5};
+    auto sy = REx::ScanData(yy.data(), yy.size());
+    SIMPLE_TEST(!sy.increasing && !sy.decreasing);
+    SIMPLE_TEST(sy.hasNaN && sy.hasInf);
+    SIMPLE_TEST(!sy.integer);
+    SIMPLE_TEST(sy.min == -2.5 && sy.max == 7 && sy.minPositive == 0.25);
+
+    // only one non-zero value in the remainder
+    zeros.back() = 1e-300;
+    SIMPLE_TEST(!REx::ScanData(zeros.data(), zeros.size()).allZero);
+
+    END_TEST();
+}
@@ -0,0 +1,6 @@
+#ifndef DATASCAN_TEST_HH
+#define DATASCAN_TEST_HH
+
+void TestDataScan();
+
+#endif
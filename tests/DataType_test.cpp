@@ -74,6 +74,15 @@ void TestDataType() {
     SIMPLE_TEST(REx::GetDataType(frm) == REx::Undefined);
     SIMPLE_TEST(REx::GetDataType(c) == REx::Undefined);
 
+    // user types: checked before the ROOT classes, for the class and its derived classes
+    SIMPLE_TEST(!REx::RegisterDataType("NotAClass", REx::Histo1D));
+    SIMPLE_TEST(REx::RegisterDataType("TLatex", REx::TextBox));
+    SIMPLE_TEST(REx::GetDataType(ltx) == REx::TextBox);
+    SIMPLE_TEST(REx::GetDataType(txt) == REx::BareText);
+    SIMPLE_TEST(REx::RegisterDataType("TLatex", REx::BareText)); // restore the default (the last registration wins)
+    SIMPLE_TEST(REx::GetDataType(ltx) == REx::BareText);
+    SIMPLE_TEST(REx::GetDataType(static_cast<TObject*>(nullptr)) == REx::Undefined);
+
     // check DataType numbering scheme (undef/1D/2D/3D)
     SIMPLE_TEST(REx::GetDataDimension(REx::Undefined) == -1)
     SIMPLE_TEST(REx::GetDataDimension(REx::Function1D) == 1)
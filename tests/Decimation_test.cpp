@@ -0,0 +1,86 @@
+#include "Decimation_test.hh"
+#include "Decimation.hh"
+#include "macros.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+void TestDecimation() {
+    BEGIN_TEST();
+
+    // noisy sine wave, much more points than pixels
+    const int n = 100000;
+    std::vector<double> xx(n), yy(n);
+    for (int i = 0; i < n; i++) {
+        xx[i] = i * 1e-4;
+        yy[i] = std::sin(xx[i]) + 0.1 * std::sin(12345.6789 * i);
+    }
+    REx::PixelColumns columns;
+    columns.n = 200;
+    columns.xmin = 1;
+    columns.xmax = 9;
+
+    // at most 4 points per column, plus the points next to the visible range
+    auto kept = REx::SelectM4(xx.data(), yy.data(), nullptr, n, columns);
+    SIMPLE_TEST(kept.size() <= 4 * 200 + 2);
+    SIMPLE_TEST(std::is_sorted(kept.begin(), kept.end()));
+    SIMPLE_TEST(xx[kept.front()] < 1 && xx[kept[1]] >= 1);
+    SIMPLE_TEST(xx[kept.back()] > 9 && xx[kept[kept.size() - 2]] <= 9);
+
+    // same lowest and highest points in each column
+    auto column = [&columns](double x) { return std::min(columns.n - 1, (int)((x - columns.xmin) * columns.n / (columns.xmax - columns.xmin))); };
+    std::vector<double> min_all(columns.n, INFINITY), max_all(columns.n, -INFINITY);
+    std::vector<double> min_kept(columns.n, INFINITY), max_kept(columns.n, -INFINITY);
+    for (int i = 0; i < n; i++) {
+        if (xx[i] < 1 || xx[i] > 9) continue;
+        int c = column(xx[i]);
+        min_all[c] = std::min(min_all[c], yy[i]);
+        max_all[c] = std::max(max_all[c], yy[i]);
+    }
+    for (int i : kept) {
+        if (xx[i] < 1 || xx[i] > 9) continue;
+        int c = column(xx[i]);
+        min_kept[c] = std::min(min_kept[c], yy[i]);
+        max_kept[c] = std::max(max_kept[c], yy[i]);
+    }
+    SIMPLE_TEST(min_all == min_kept && max_all == max_kept);
+
+    // points not sorted: the indices follow the given order
+    std::vector<double> xr(xx.rbegin(), xx.rend()), yr(yy.rbegin(), yy.rend());
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++)
+        order[i] = n - 1 - i;
+    auto kept_r = REx::SelectM4(xr.data(), yr.data(), order.data(), n, columns);
+    SIMPLE_TEST(kept_r.size() == kept.size() && kept_r[0] == n - 1 - kept[0]);
+
+    // logarithmic axis: the points with x <= 0 are not drawn
+    columns.logx = true;
+    columns.xmin = 0.01;
+    kept = REx::SelectM4(xx.data(), yy.data(), nullptr, n, columns);
+    SIMPLE_TEST(kept.size() <= 4 * 200 + 2 && xx[kept.front()] > 0);
+
+    // few points or invalid columns: all the points are kept
+    SIMPLE_TEST(REx::SelectM4(xx.data(), yy.data(), nullptr, 800, columns).size() == 800);
+    columns.xmin = -1; // log axis
+    SIMPLE_TEST(!columns.IsValid());
+    SIMPLE_TEST((int)REx::SelectM4(xx.data(), yy.data(), nullptr, n, columns).size() == n);
+
+    // levels of a pyramid: reduced by 4, sorted, with the extrema of the whole data
+    std::vector<int> level(n);
+    for (int i = 0; i < n; i++)
+        level[i] = i;
+    auto reduced = REx::ReduceM4(yy.data(), level);
+    SIMPLE_TEST((int)reduced.size() <= n / 4 + 4 && (int)reduced.size() >= n / 8);
+    SIMPLE_TEST(std::is_sorted(reduced.begin(), reduced.end()));
+    SIMPLE_TEST(reduced.front() == 0 && reduced.back() == n - 1);
+    int imin = std::min_element(yy.begin(), yy.end()) - yy.begin();
+    int imax = std::max_element(yy.begin(), yy.end()) - yy.begin();
+    auto coarse = REx::ReduceM4(yy.data(), reduced);
+    SIMPLE_TEST(std::count(coarse.begin(), coarse.end(), imin) == 1 && std::count(coarse.begin(), coarse.end(), imax) == 1);
+    SIMPLE_TEST(REx::ReduceM4(yy.data(), std::vector<int>{3, 5, 7}) == (std::vector<int>{3, 5, 7}));
+    SIMPLE_TEST(REx::ReduceM4(yy.data(), std::vector<int>()).empty());
+
+    END_TEST();
+}
@@ -0,0 +1,6 @@
+#ifndef DECIMATION_TEST_HH
+#define DECIMATION_TEST_HH
+
+void TestDecimation();
+
+#endif
@@ -1,8 +1,12 @@
 #include "ExPad_test.hh"
+#include "ArchiveSink.hh"
 #include "GleExportManager.hh"
 #include "GnuplotExportManager.hh"
+#include "OutputSink.hh"
+#include "PlotBuilder.hh"
 #include "PlotSerializer.hh"
 #include "PyplotExportManager.hh"
+#include "WatchService.hh"
 #include "macros.hh"
 
 #include "TArrow.h"
@@ -21,8 +25,29 @@
 #include "TSystem.h"
 #include "TText.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <future>
 #include <iostream>
 #include <memory>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+/// @brief Memory sink counting the files written
+struct CountingSink : public REx::MemorySink {
+    std::atomic<int> nwritten{0};
+    bool Close(const char* path, std::ofstream& ofs, const char* content_type) override {
+        nwritten++;
+        return REx::MemorySink::Close(path, ofs, content_type);
+    }
+};
+
+} // namespace
 
 void TestPlotSerializer() {
     BEGIN_TEST();
@@ -74,6 +99,22 @@ void TestPlotSerializer() {
         COMPARE_TSTRING(ps->GetDatasetTitle(0), "h"); // should still be 'h' (legend built before the title was changed)
         COMPARE_TSTRING(ps->GetDatasetTitle(2), "gaus");
         COMPARE_TSTRING(ps->GetPlotTitle(), "hs"); // title has not changed
+        // incremental serialization: only the modified objects are extracted again
+        SIMPLE_TEST(ps->Update() == 0);
+        SIMPLE_TEST(ps->GetNumberOfDatasets() == 3 && ps->GetPreviousIndex(2) == 2);
+        h2->Fill(3);
+        SIMPLE_TEST(ps->Update() == 2); // the stack changed (both histograms), not the function
+        SIMPLE_TEST(ps->GetPreviousIndex(1) == -1 && ps->GetPreviousIndex(2) == 2);
+        COMPARE_TSTRING(ps->GetDatasetTitle(0), "h"); // label still taken from the legend
+        // fingerprints of the pad hash reused by the serialization (same result as without them)
+        REx::FingerprintCache fingerprints;
+        REx::ComputePadHash(c1, &fingerprints);
+        SIMPLE_TEST(!fingerprints.empty());
+        SIMPLE_TEST(ps->Update(&fingerprints) == 0 && ps->GetPreviousIndex(1) == 1);
+        h2->Fill(4);
+        fingerprints.clear();
+        REx::ComputePadHash(c1, &fingerprints);
+        SIMPLE_TEST(ps->Update(&fingerprints) == 2 && ps->GetPreviousIndex(2) == 2);
     }
     catch (const std::exception& e) {
         EXCEPTION_CAUGHT(e);
@@ -119,8 +160,107 @@ void TestPlotSerializer() {
     }
 
     delete ps;
+    ps = nullptr;
     delete c2;
 
+    // CASE 3 - divided canvas (the empty subpad is ignored)
+    TCanvas* c3 = new TCanvas("c3", "c3");
+    c3->Divide(2, 2);
+    TH1D* hd[3];
+    for (int i = 0; i < 3; i++) {
+        hd[i] = new TH1D(TString::Format("hd%d", i), TString::Format("hd%d;x;y", i), 10, 0, 10);
+        hd[i]->Fill(i);
+        c3->cd(i + 1);
+        hd[i]->Draw();
+    }
+    c3->Update();
+    try {
+        ps = new REx::PlotSerializer(c3);
+        SIMPLE_TEST(ps->GetNumberOfDatasets() == 0);
+        SIMPLE_TEST(ps->GetNumberOfSubpads() == 3);
+        SIMPLE_TEST(ps->GetSubpad(1)->GetNumberOfDatasets() == 1);
+        COMPARE_TSTRING(ps->GetSubpad(1)->GetDatasetTitle(0), "hd1");
+    }
+    catch (const std::exception& e) {
+        EXCEPTION_CAUGHT(e);
+    }
+    delete ps;
+    ps = nullptr;
+    delete c3;
+    for (auto hdi : hd)
+        delete hdi;
+
+    // CASE 4 - plot described without pad (nothing is drawn)
+    {
+        int ncanvas = gROOT->GetListOfCanvases()->GetSize();
+        TH1D hv("hv", "hv;xv;yv", 10, 0, 10);
+        TGraph grv(2);
+        grv.SetPoint(0, 1, 1);
+        grv.SetPoint(1, 2, 3);
+        REx::PlotBuilder plot("virtual");
+        plot.Add(&hv, "HIST").Add(&grv, "P").AddLegendEntry(&grv, "points");
+        try {
+            ps = new REx::PlotSerializer(plot);
+            SIMPLE_TEST(ps->GetNumberOfDatasets() == 2);
+            COMPARE_TSTRING(ps->GetPlotTitle(), "hv"); // title of the frame object
+            COMPARE_TSTRING(ps->GetXaxisTitle(), "xv");
+            COMPARE_TSTRING(ps->GetDatasetTitle(1), "points");
+            SIMPLE_TEST(ps->GetLegendPosition() == REx::PlotBuilder::kTopRight);
+        }
+        catch (const std::exception& e) {
+            EXCEPTION_CAUGHT(e);
+        }
+        delete ps;
+        ps = nullptr;
+        SIMPLE_TEST(gROOT->GetListOfCanvases()->GetSize() == ncanvas);
+        REx::PlotBuilder empty("empty");
+        EXPECTED_EXCEPTION(ps = new REx::PlotSerializer(empty), std::runtime_error);
+        EXPECTED_EXCEPTION(empty.Add(nullptr), std::invalid_argument);
+    }
+
+    // CASE 5 - large multigraph with a full legend: every entry labels its graph, for N and 10N graphs
+    // (the serialization times are reported, not tested: they depend on the machine load)
+    {
+        const int sizes[2] = {400, 4000};
+        double elapsed[2] = {0, 0}; // ms
+        for (int k = 0; k < 2; k++) {
+            const int n = sizes[k];
+            TCanvas* cs = new TCanvas("c_scaling", "c_scaling");
+            TMultiGraph* mgs = new TMultiGraph();
+            TLegend* legs = new TLegend(0.1, 0.1, 0.3, 0.3);
+            for (int i = 0; i < n; i++) {
+                TGraph* gs = new TGraph(2);
+                gs->SetName(TString::Format("gs%d", i));
+                gs->SetPoint(0, 0, i);
+                gs->SetPoint(1, 1, i);
+                mgs->Add(gs, "l");
+                legs->AddEntry(gs, TString::Format("entry %d", i));
+            }
+            legs->AddEntry((TObject*)nullptr, "header", ""); // entry without object
+            mgs->Draw("a");
+            legs->Draw();
+            try {
+                auto t0 = std::chrono::steady_clock::now();
+                REx::PlotSerializer pss(cs);
+                elapsed[k] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                SIMPLE_TEST(pss.GetNumberOfDatasets() == n);
+                int matched = 0;
+                for (int i = 0; i < pss.GetNumberOfDatasets(); i++)
+                    if (pss.GetDatasetTitle(i) == TString::Format("entry %d", i)) matched++;
+                SIMPLE_TEST(matched == n);
+            }
+            catch (const std::exception& e) {
+                EXCEPTION_CAUGHT(e);
+            }
+            delete cs;
+            delete legs;
+            delete mgs; // the graphs are owned by the multigraph
+        }
+        // linear scaling: about 10 times longer for 10 times more graphs (100 times if quadratic)
+        LOG_INFO("Serialization of " << sizes[0] << " / " << sizes[1] << " graphs with legend: " << elapsed[0] << " / "
+                                     << elapsed[1] << " ms (ratio " << (elapsed[0] > 0 ? elapsed[1] / elapsed[0] : 0) << ")");
+    }
+
     delete mg; // gr and gre are owned by the multigraph (they should not be deleted !)
     delete hs;
     delete h;
@@ -251,6 +391,313 @@ void TestExportManager() {
         SIMPLE_TEST(!gSystem->AccessPathName("output/python/gre2_c2.txt"));
         SIMPLE_TEST(!gSystem->AccessPathName("output/python/c2.py"));
 
+        // in-memory export (nothing is written on disk)
+        REx::MemorySink mem;
+        pyplot_man->SetOutputSink(&mem);
+        pyplot_man->SetDataDirectory("data");
+        pyplot_man->ExportPad(c2, "output/memory/c2");
+        pyplot_man->SetOutputSink(nullptr);
+        pyplot_man->SetDataDirectory("");
+        SIMPLE_TEST(gSystem->AccessPathName("output/memory"));
+        SIMPLE_TEST(mem.GetEntries().size() == 4);
+        auto script = mem.GetEntry("output/memory/c2.py");
+        SIMPLE_TEST(script && script->contentType == "text/x-python");
+        SIMPLE_TEST(script && script->content.find("\"data/gre1_c2.txt\"") != std::string::npos);
+        auto data = mem.GetEntry("output/memory/data/gre1_c2.txt");
+        SIMPLE_TEST(data && data->contentType == "text/plain" && data->content.size() > 0);
+
+        // decimation of a large graph drawn with a line: at most 4 points per pixel column of the frame
+        {
+            TCanvas* cd = new TCanvas("c_decim", "c_decim", 600, 400);
+            const int np = 200000;
+            TGraph* gd = new TGraph(np);
+            gd->SetName("gd");
+            for (int i = 0; i < np; i++)
+                gd->SetPoint(i, i, std::sin(0.001 * i) + 0.1 * std::sin(1.7 * i));
+            gd->Draw("al");
+            cd->Update();
+            REx::MemorySink mem_decim;
+            REx::PyplotExportManager pyplot_decim;
+            pyplot_decim.SetOutputSink(&mem_decim);
+            pyplot_decim.EnableDecimation();
+            pyplot_decim.ExportPad(cd, "output/memory/decim");
+            auto decim = mem_decim.GetEntry("output/memory/gd.txt");
+            SIMPLE_TEST(decim && decim->content.find("# M4 decimation") != std::string::npos);
+            SIMPLE_TEST(decim && std::count(decim->content.begin(), decim->content.end(), '\n') < 4 * 600 + 10);
+
+            // level-of-detail pyramid: all the points, coarsest level first, read by the script when zooming
+            REx::MemorySink mem_lod;
+            REx::PyplotExportManager pyplot_lod;
+            pyplot_lod.SetOutputSink(&mem_lod);
+            pyplot_lod.EnableLevelOfDetail();
+            pyplot_lod.ExportPad(cd, "output/memory/lod");
+            auto lod = mem_lod.GetEntry("output/memory/gd.txt");
+            auto lod_script = mem_lod.GetEntry("output/memory/lod.py");
+            SIMPLE_TEST(lod && lod->content.find("# LOD level 0 factor 1 rows 200000 offset") != std::string::npos);
+            SIMPLE_TEST(lod && std::count(lod->content.begin(), lod->content.end(), '\n') > np);
+            SIMPLE_TEST(lod_script && lod_script->content.find("d1 = lod.load(\"gd.txt\")") != std::string::npos);
+            SIMPLE_TEST(lod_script && lod_script->content.find("\"xlim_changed\"") != std::string::npos);
+            delete cd;
+            delete gd;
+        }
+
+        // one pad exported with all the backends: serialized once, data files shared by gnuplot and python
+        {
+            CountingSink multi;
+            REx::GleExportManager gle_multi;
+            REx::GnuplotExportManager gnuplot_multi;
+            REx::PyplotExportManager pyplot_multi;
+            gle_multi.SaveInFolder(true); // GLE data files (comment character '!') in a separate folder
+            for (REx::BaseExportManager* man : std::vector<REx::BaseExportManager*>{&gle_multi, &gnuplot_multi, &pyplot_multi})
+                man->SetOutputSink(&multi);
+            REx::BaseExportManager::ExportPad(c2, "output/multi/c2", {&gle_multi, &gnuplot_multi, &pyplot_multi});
+            SIMPLE_TEST(multi.nwritten == 9); // 3 scripts + 2 x 3 data files
+            SIMPLE_TEST(multi.GetEntry("output/multi/c2/c2.gle") && multi.GetEntry("output/multi/c2/gre1_c2.txt"));
+            SIMPLE_TEST(multi.GetEntry("output/multi/c2.gp") && multi.GetEntry("output/multi/c2.py"));
+            auto gle_data = multi.GetEntry("output/multi/c2/gr_c2.txt");
+            auto txt_data = multi.GetEntry("output/multi/gr_c2.txt");
+            SIMPLE_TEST(gle_data && gle_data->content.find('!') == 0);
+            SIMPLE_TEST(txt_data && txt_data->content.find('#') == 0);
+
+            // a manager ignoring the list of functions gets its own serialization
+            TCanvas* cf = new TCanvas("c_func", "c_func");
+            TH1D* hf = new TH1D("hf", "hf", 20, 0, 10);
+            hf->FillRandom("f", 200);
+            TF1* fit = new TF1("fit_hf", "gausn", 0, 10);
+            hf->GetListOfFunctions()->Add(fit);
+            hf->Draw();
+            cf->Update();
+            REx::MemorySink mem_func;
+            REx::GnuplotExportManager gnuplot_func;
+            REx::PyplotExportManager pyplot_func;
+            gnuplot_func.IgnoreListOfFunctions(true);
+            gnuplot_func.SetOutputSink(&mem_func);
+            pyplot_func.SetOutputSink(&mem_func);
+            SIMPLE_TEST(REx::BaseExportManager::ExportPad(cf, "output/memory/func", {&gnuplot_func, &pyplot_func}));
+            auto gp_func = mem_func.GetEntry("output/memory/func.gp");
+            auto py_func = mem_func.GetEntry("output/memory/func.py");
+            SIMPLE_TEST(gp_func && gp_func->content.find("fit_hf") == std::string::npos);
+            SIMPLE_TEST(py_func && py_func->content.find("fit_hf") != std::string::npos);
+            delete cf;
+            delete hf;
+        }
+
+        // snapshot of the plot properties: the scripts are written again without the ROOT objects
+        {
+            auto read_file = [](const char* name) {
+                std::ifstream ifs(name);
+                std::stringstream ss;
+                ss << ifs.rdbuf();
+                return ss.str();
+            };
+            gSystem->mkdir("output/snapshot");
+            pyplot_man->EnableSnapshot();
+            pyplot_man->ExportPad(c2, "output/snapshot/c2");
+            pyplot_man->EnableSnapshot(false);
+            SIMPLE_TEST(!gSystem->AccessPathName("output/snapshot/c2.rexp"));
+            std::string original = read_file("output/snapshot/c2.py");
+            gSystem->Unlink("output/snapshot/c2.py");
+            SIMPLE_TEST(pyplot_man->ExportSnapshot("output/snapshot/c2.rexp"));
+            SIMPLE_TEST(original.size() > 0 && read_file("output/snapshot/c2.py") == original);
+            SIMPLE_TEST(gnuplot_man->ExportSnapshot("output/snapshot/c2.rexp"));
+            SIMPLE_TEST(!gSystem->AccessPathName("output/snapshot/c2.gp"));
+            SIMPLE_TEST(!gnuplot_man->ExportSnapshot("output/snapshot/c2.py")); // not a snapshot
+        }
+
+        // asynchronous export: the pad and its objects can be deleted right after the call
+        {
+            gSystem->mkdir("output/async");
+            TCanvas* ca = new TCanvas("ca", "ca");
+            TH1D* ha = new TH1D("h_async", "h_async;x;y", 100, 0, 10);
+            ha->FillRandom("gaus", 1000);
+            ha->Draw("E");
+            ca->Update();
+            auto done = pyplot_man->ExportPadAsync(ca, "output/async/ca");
+            auto done_copy = pyplot_man->ExportPadAsync(ca, "output/async/ca_copy");
+            delete ca;
+            delete ha;
+            REx::BaseExportManager::WaitForExports();
+            SIMPLE_TEST(done_copy.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+            SIMPLE_TEST(!gSystem->AccessPathName("output/async/ca_copy.py"));
+            SIMPLE_TEST(done.get());
+            SIMPLE_TEST(!gSystem->AccessPathName("output/async/ca.py"));
+            std::ifstream ifs("output/async/h_async.txt");
+            std::string line;
+            int nlines = 0;
+            while (std::getline(ifs, line))
+                if (line[0] != '#') nlines++;
+            SIMPLE_TEST(nlines == 100);
+        }
+
+        // batch export (pipelined stages), with a per-pad report
+        {
+            gSystem->mkdir("output/batch");
+            std::vector<TVirtualPad*> pads;
+            std::vector<TString> names;
+            std::vector<TH1D*> histos;
+            for (int i = 0; i < 6; i++) {
+                TString name = TString::Format("pb%d", i);
+                pads.push_back(new TCanvas(name, name));
+                names.push_back("output/batch/" + name);
+                if (i == 3) continue; // empty pad : cannot be exported
+                histos.push_back(new TH1D("h_" + name, "h_" + name, 20, 0, 10));
+                histos.back()->FillRandom("gaus", 100);
+                histos.back()->Draw();
+                pads.back()->Update();
+            }
+            auto report = pyplot_man->ExportPads(pads, names, 2);
+            SIMPLE_TEST(report.size() == 6);
+            int nok = 0;
+            for (size_t i = 0; i < report.size(); i++) {
+                if (report[i].ok) nok++;
+                if (i != 3) {
+                    SIMPLE_TEST(report[i].ok && report[i].pad == pads[i]->GetName());
+                    SIMPLE_TEST(!gSystem->AccessPathName(report[i].filename));
+                }
+            }
+            SIMPLE_TEST(nok == 5);
+            SIMPLE_TEST(!report[3].ok && report[3].error.Length() > 0);
+            SIMPLE_TEST(!gSystem->AccessPathName("output/batch/h_pb5.txt"));
+            EXPECTED_EXCEPTION(pyplot_man->ExportPads(pads, std::vector<TString>(2)), std::invalid_argument);
+            for (auto pb : pads)
+                delete pb;
+            for (auto hb : histos)
+                delete hb;
+        }
+
+        // divided canvas : one script with subplots, data files prefixed with the subpad names
+        TCanvas* c3 = new TCanvas("c3", "c3", 800, 600);
+        c3->Divide(2, 1);
+        c3->cd(1);
+        h->Draw();
+        c3->cd(2);
+        mg->Draw("a");
+        c3->Update();
+        pyplot_man->ExportPad(c3, "output/python/c3");
+        SIMPLE_TEST(!gSystem->AccessPathName("output/python/c3.py"));
+        SIMPLE_TEST(!gSystem->AccessPathName("output/python/c3_1_h.txt"));
+        SIMPLE_TEST(!gSystem->AccessPathName("output/python/c3_2_gre1_c2.txt"));
+        gle_man->SetDataDirectory("data_c3");
+        gle_man->ExportPad(c3, "output/gle/c3.gle");
+        SIMPLE_TEST(!gSystem->AccessPathName("output/gle/data_c3/c3_1_h.txt"));
+        gnuplot_man->ExportPad(c3, "output/gnuplot/c3");
+        SIMPLE_TEST(!gSystem->AccessPathName("output/gnuplot/c3_2_gr_c2.txt"));
+        delete c3;
+
+        // plot described without pad: axis ranges computed from the data with the rules of the ROOT painters
+        {
+            REx::MemorySink headless;
+            REx::PyplotExportManager pyplot_headless;
+            pyplot_headless.SetOutputSink(&headless);
+            TH1D hb("hb", "headless;x;y", 10, 0, 10);
+            for (int k = 1; k <= 10; k++)
+                hb.SetBinContent(k, 10 + k); // 11 ... 20
+            REx::PlotBuilder plot("headless");
+            plot.Add(&hb, "HIST");
+            SIMPLE_TEST(pyplot_headless.ExportPlot(plot, "output/headless/h"));
+            auto script_h = headless.GetEntry("output/headless/h.py");
+            SIMPLE_TEST(script_h && script_h->content.find("ax.set_xlim(0, 10)") != std::string::npos);
+            SIMPLE_TEST(script_h && script_h->content.find("ax.set_ylim(10.55, 20.4725)") != std::string::npos); // 5% margins
+            SIMPLE_TEST(headless.GetEntry("output/headless/hb.txt"));
+
+            TGraph gb(2);
+            gb.SetName("gb");
+            gb.SetPoint(0, 1, 1);
+            gb.SetPoint(1, 2, 3);
+            plot.Clear();
+            plot.Add(&gb, "AP").Add(&hb, "HIST SAME").SetYRange(0, 5);
+            SIMPLE_TEST(pyplot_headless.ExportPlot(plot, "output/headless/g"));
+            auto script_g = headless.GetEntry("output/headless/g.py");
+            SIMPLE_TEST(script_g && script_g->content.find("ax.set_xlim(0.9, 2.1)") != std::string::npos); // 10% margins
+            SIMPLE_TEST(script_g && script_g->content.find("ax.set_ylim(0, 5)") != std::string::npos);      // user range
+        }
+
+        // incremental export: the data files of the unmodified objects are not written again
+        {
+            CountingSink live_sink;
+            REx::PyplotExportManager pyplot_live;
+            pyplot_live.SetOutputSink(&live_sink);
+            TCanvas* cl = new TCanvas("cl", "cl");
+            TH1D* hl1 = new TH1D("hl1", "hl1", 20, 0, 10);
+            TH1D* hl2 = new TH1D("hl2", "hl2", 20, 0, 10);
+            hl1->FillRandom("gaus", 100);
+            hl2->FillRandom("gaus", 100);
+            hl1->Draw();
+            hl2->Draw("SAME");
+            TLegend* leg = new TLegend(0.6, 0.7, 0.9, 0.9);
+            leg->AddEntry(hl2, "second");
+            leg->Draw();
+            cl->Update();
+            REx::IncrementalExport live(cl, "output/live/cl", {&pyplot_live});
+            SIMPLE_TEST(live.Export() && live.GetNumberOfDatasetsWritten() == 2 && live_sink.nwritten == 3);
+            SIMPLE_TEST(live.Export() && live.GetNumberOfDatasetsWritten() == 0 && live_sink.nwritten == 4); // script only
+            hl2->Fill(5.);
+            cl->Modified();
+            cl->Update();
+            SIMPLE_TEST(live.Export() && live.GetNumberOfDatasetsWritten() == 1 && live_sink.nwritten == 6);
+            auto script_l = live_sink.GetEntry("output/live/cl.py");
+            SIMPLE_TEST(script_l && script_l->content.find("second") != std::string::npos);
+            SIMPLE_TEST(script_l && script_l->content.find("\"hl1.txt\"") != std::string::npos); // kept data file
+            delete cl;
+            delete leg;
+            delete hl1;
+            delete hl2;
+        }
+
+        // watch mode: one export per modification, at most once per interval
+        {
+            REx::MemorySink watch_sink;
+            REx::PyplotExportManager pyplot_watch;
+            pyplot_watch.SetOutputSink(&watch_sink);
+            TCanvas* cw = new TCanvas("cw", "cw");
+            TH1D* hw = new TH1D("hw", "hw", 20, 0, 10);
+            hw->FillRandom("gaus", 100);
+            hw->Draw();
+            cw->Update();
+            REx::WatchService watch({&pyplot_watch});
+            watch.Watch(cw, 0, "output/watch/cw");
+            SIMPLE_TEST(watch.Poll() == 1);
+            watch.Flush();
+            SIMPLE_TEST(watch.Poll() == 0); // not modified
+            hw->Fill(1.);
+            SIMPLE_TEST(watch.Poll() == 1);
+            watch.Flush();
+            auto stats = watch.GetStats();
+            SIMPLE_TEST(stats.size() == 1 && stats[0].nexports == 2 && stats[0].nunchanged == 1);
+            SIMPLE_TEST(stats.size() == 1 && stats[0].nfailed == 0 && stats[0].ndatasets == 2);
+            SIMPLE_TEST(watch_sink.GetEntry("output/watch/cw.py") && watch_sink.GetEntry("output/watch/hw.txt"));
+            // long interval: the modifications wait for the deadline
+            watch.Watch(cw, 1e6, "output/watch/cw");
+            SIMPLE_TEST(watch.Poll() == 1);
+            hw->Fill(2.);
+            SIMPLE_TEST(watch.Poll() == 0);
+            watch.Unwatch(cw);
+            SIMPLE_TEST(watch.GetStats().empty());
+            EXPECTED_EXCEPTION(watch.Watch(nullptr, 10), std::invalid_argument);
+            delete cw;
+            delete hw;
+        }
+
+        // both pads in a single archive (paths relative to "output/archive")
+        {
+            REx::ArchiveSink tar("output/plots.tar", REx::ArchiveSink::kNone, "output/archive");
+            pyplot_man->SetOutputSink(&tar);
+            pyplot_man->ExportPad(c1, "output/archive/c1");
+            pyplot_man->ExportPad(c2, "output/archive/c2");
+            pyplot_man->SetOutputSink(nullptr);
+            SIMPLE_TEST(tar.GetNumberOfEntries() == 7);
+            SIMPLE_TEST(tar.Exists("output/archive/c1.py") && tar.Exists("output/archive/gre2_c2.txt"));
+            SIMPLE_TEST(tar.Close() && !tar.IsFailed());
+            SIMPLE_TEST(!tar.IsOpen());
+            // the files cannot be added to a closed archive: the export fails
+            pyplot_man->SetOutputSink(&tar);
+            SIMPLE_TEST(!REx::BaseExportManager::ExportPad(c1, "output/archive/c1", {pyplot_man.get()}));
+            pyplot_man->SetOutputSink(nullptr);
+            SIMPLE_TEST(tar.GetNumberOfEntries() == 7);
+        }
+        SIMPLE_TEST(gSystem->AccessPathName("output/archive"));
+        SIMPLE_TEST(!gSystem->AccessPathName("output/plots.tar"));
+
         // Prepare next test --> using external tools to render the plots
         // - save plots as PDF using ROOT internal method (for comparison)
         c1->SaveAs("output/c1.pdf");
@@ -260,14 +707,17 @@ void TestExportManager() {
         ofs.open("output/gle.out");
         ofs << "gle/c1/c1.gle\n";
         ofs << "gle/c2.gle\n";
+        ofs << "gle/c3.gle\n";
         ofs.close();
         ofs.open("output/gnuplot.out");
         ofs << "gnuplot/c1.gp\n";
         ofs << "gnuplot/c2.gp\n";
+        ofs << "gnuplot/c3.gp\n";
         ofs.close();
         ofs.open("output/python.out");
         ofs << "python/c1.py\n";
         ofs << "python/c2.py\n";
+        ofs << "python/c3.py\n";
         ofs.close();
     }
     catch (const std::exception& e) {
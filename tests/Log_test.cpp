@@ -0,0 +1,99 @@
+#include "Log_test.hh"
+#include "Logger.hh"
+#include "macros.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int count_lines(const char* filename) {
+    std::ifstream ifs(filename);
+    std::string line;
+    int n = 0;
+    while (getline(ifs, line))
+        n++;
+    return n;
+}
+
+} // namespace
+
+void TestLogger() {
+    BEGIN_TEST();
+    REx::Logger* logger = REx::Logger::GetInstance();
+    const char* json = "logger_test.json";
+    std::remove(json);
+    SIMPLE_TEST(logger->SetJsonFile(json));
+    logger->SetConsole(false);
+
+    // messages below the level are not even formatted
+    int formatted = 0;
+    auto format = [&formatted]() { return ++formatted; };
+    REx::Logger::SetLevel(REx::Logger::kWarning);
+    LOG_INFO("not formatted " << format());
+    SIMPLE_TEST(formatted == 0);
+    LOG_WARN("formatted " << format());
+    SIMPLE_TEST(formatted == 1);
+    REx::Logger::SetLevel(REx::Logger::kDebug);
+
+    // rate limit : 5 messages per second for each site
+    REx::Logger::SetRateLimit(5);
+    for (int i = 0; i < 20; i++)
+        LOG_WARN("repeated warning " << i);
+    const REx::LogSite* site = logger->GetSites(); // last registered site
+    SIMPLE_TEST(site && site->GetCount() == 20 && site->GetSuppressed() == 15);
+    logger->Flush(); // suppressed messages reported
+    SIMPLE_TEST(site->GetPending() == 0);
+    SIMPLE_TEST(count_lines(json) == 1 + 5 + 1);
+
+    // the errors are never suppressed
+    for (int i = 0; i < 20; i++)
+        LOG_ERROR("repeated error " << i);
+    site = logger->GetSites();
+    SIMPLE_TEST(site && site->GetCount() == 20 && site->GetSuppressed() == 0);
+    logger->Flush();
+    SIMPLE_TEST(count_lines(json) == 1 + 5 + 1 + 20);
+
+    // asynchronous mode
+    REx::Logger::SetRateLimit(0);
+    logger->SetAsync(true);
+    SIMPLE_TEST(logger->IsAsync());
+    for (int i = 0; i < 10000; i++)
+        LOG_INFO("asynchronous message " << i);
+    logger->Flush();
+    logger->SetAsync(false);
+    SIMPLE_TEST(count_lines(json) == 1 + 5 + 1 + 20 + 10000);
+
+    // mode switched while other threads log : no message is lost
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+        threads.emplace_back([t]() {
+            for (int i = 0; i < 1000; i++)
+                LOG_INFO("thread " << t << " message " << i);
+        });
+    for (int k = 0; k < 20; k++)
+        logger->SetAsync(k % 2 == 0);
+    for (auto& th : threads)
+        th.join();
+    logger->SetAsync(false);
+    logger->Flush();
+    SIMPLE_TEST(count_lines(json) == 1 + 5 + 1 + 20 + 10000 + 4000);
+
+    // JSON lines
+    std::ifstream ifs(json);
+    std::string line;
+    getline(ifs, line);
+    SIMPLE_TEST(line.find("\"level\":\"WARNING\"") != std::string::npos);
+    SIMPLE_TEST(line.find("\"msg\":\"formatted 1\"") != std::string::npos);
+    ifs.close();
+
+    logger->SetJsonFile("");
+    logger->SetConsole(true);
+    REx::Logger::SetRateLimit(20);
+    std::remove(json);
+    END_TEST();
+}
@@ -0,0 +1,6 @@
+#ifndef LOG_TEST_HH
+#define LOG_TEST_HH
+
+void TestLogger();
+
+#endif
@@ -1,14 +1,20 @@
 #include "RTT_test.hh"
+#include "FileMerger.hh"
+#include "PathResolver.hh"
 #include "ROOTToText.hh"
+#include "RTTSnapshot.hh"
 #include "macros.hh"
 
 #include "TF1.h"
+#include "TFile.h"
 #include "TGraph.h"
 #include "TGraph2D.h"
 #include "TGraphErrors.h"
 #include "TH1D.h"
 #include "TH2D.h"
 #include "TH3D.h"
+#include "TLatex.h"
+#include "TROOT.h"
 #include "THStack.h"
 #include "TMultiGraph.h"
 #include "TString.h"
@@ -53,6 +59,16 @@ void TestRTTConfig() {
     TString rtt_dir(gSystem->UnixPathName(gRTT->GetDirectory())); // small trick otherwise the test fails in Windows
     COMPARE_TSTRING(rtt_dir, dir_name1);
     EXPECTED_EXCEPTION(gRTT->SetDirectory(__FILE__), std::invalid_argument);
+
+    // file name patterns
+    SIMPLE_TEST(REx::PathResolver::HasFileExtension("dir/file.txt"));
+    SIMPLE_TEST(REx::PathResolver::HasFileExtension(".dat"));
+    SIMPLE_TEST(!REx::PathResolver::HasFileExtension("dir/file"));
+    SIMPLE_TEST(!REx::PathResolver::HasFileExtension("file."));
+    SIMPLE_TEST(!REx::PathResolver::HasFileExtension("file.t_t"));
+    SIMPLE_TEST(REx::PathResolver::IsFileName("./dir/file.txt"));
+    SIMPLE_TEST(!REx::PathResolver::IsFileName("./dir/.txt"));
+    SIMPLE_TEST(!REx::PathResolver::IsFileName("./output"));
     END_TEST();
 }
 
@@ -107,6 +123,15 @@ void TestRTTOutput() {
     auto hs = new THStack("hs", "hs");
     hs->Add(h);
 
+    // THStack with several histograms (stacked with option 'S')
+    TH1D* hb = new TH1D("hb", "background;x;y", N, 0.5, N + 0.5);
+    for (int k = 1; k <= N; k++) {
+        hb->SetBinContent(k, 1);
+    }
+    auto hss = new THStack("hss", "hss");
+    hss->Add(h);
+    hss->Add(hb);
+
     // TGraph2D
     TGraph2D* gr2d = new TGraph2D(N * N);
     gr2d->SetName("gr2d");
@@ -123,6 +148,7 @@ void TestRTTOutput() {
 
     // TText
     TText* text = new TText(0, 0, "100");
+    TLatex* latex = new TLatex(0, 0, "200");
 
     gRTT->SetDirectory("./output/test_rtt");
     gRTT->SetFileExtension(".txt");
@@ -143,6 +169,7 @@ void TestRTTOutput() {
     SIMPLE_TEST(gRTT->SaveObject(h, "h_lowedge_and_errors.dat", "EL"));
     SIMPLE_TEST(gRTT->SaveObject(gre, "gre_horizontal_errors.txt", "H"));
     SIMPLE_TEST(gRTT->SaveObject(h2, "h2_columns", "C"));
+    SIMPLE_TEST(gRTT->SaveObject(hss, "hstack_stacked", "S"));
 
     // Use a custom writer
     REx::rtt_writer fw = [](const TObject* obj, const TString& /*opt*/, std::ofstream& ofs) {
@@ -161,8 +188,10 @@ void TestRTTOutput() {
     SIMPLE_TEST(gRTT->SaveObject(f, "", "D N3"));    // save f with default writer
     SIMPLE_TEST(gRTT->SaveObject(f, "func_custom")); // use custom writer
     SIMPLE_TEST(gRTT->SaveObject(text, "text"));     // use custom writer (TText is not supported by default)
+    SIMPLE_TEST(gRTT->SaveObject(latex, "latex"));   // use the writer of the base class TText
 
     gRTT->ClearCustomWriters();
+    EXPECTED_EXCEPTION(gRTT->SaveObject(latex, "latex_default"), std::invalid_argument); // writer no longer resolved
 
     // read files
     double sum_y = 0;
@@ -196,17 +225,126 @@ void TestRTTOutput() {
     SIMPLE_TEST(check_file_content("./output/test_rtt/gre_horizontal_errors.txt", 4, N, sum_ex, 3));
     SIMPLE_TEST(check_file_content("./output/test_rtt/gre_horizontal_errors.txt", 4, N, sum_ey, 4));
     SIMPLE_TEST(check_file_content("./output/test_rtt/h2_columns.txt", 3, N * N, sum_z, 3));
+    SIMPLE_TEST(check_file_content("./output/test_rtt/hstack_stacked_h.txt", 2, N, sum_y, 2));
+    SIMPLE_TEST(check_file_content("./output/test_rtt/hstack_stacked_hb.txt", 2, N, sum_y + N, 2));
     SIMPLE_TEST(check_file_content("./output/test_rtt/text.txt", 1, 1, 100, 0));
+    SIMPLE_TEST(check_file_content("./output/test_rtt/latex.txt", 1, 1, 200, 0));
     SIMPLE_TEST(check_file_content("./output/test_rtt/func_custom.txt", 1, 1, 101, 0));
 
+    // columns in memory (same content as the files)
+    REx::ColumnData cols;
+    SIMPLE_TEST(gRTT->GetColumns(h, cols, "E"));
+    SIMPLE_TEST(cols.GetNumberOfColumns() == 3 && cols.GetNumberOfRows() == N);
+    SIMPLE_TEST(cols.IsView("Y") && !cols.IsView("X")); // TH1D contents are not copied
+    SIMPLE_TEST(cols.GetData("Y")[N - 1] == yy[N - 1] && cols.GetData("EY")[0] == ey[0]);
+    SIMPLE_TEST(gRTT->GetColumns(gre, cols, "H"));
+    SIMPLE_TEST(cols.GetNumberOfColumns() == 4 && cols.IsView("EX") && cols.GetData("EX")[1] == ex[1]);
+    SIMPLE_TEST(gRTT->GetStackLayerColumns(hss, 1, cols));
+    SIMPLE_TEST(cols.GetNumberOfRows() == N && !cols.IsView("Y") && cols.GetData("Y")[0] == yy[0] + 1);
+    SIMPLE_TEST(gRTT->GetColumns(f, cols, "N3"));
+    SIMPLE_TEST(cols.GetNumberOfRows() == 3 && cols.GetData("Y")[2] == 4);
+    SIMPLE_TEST(!gRTT->GetColumns(hss, cols) && cols.GetNumberOfColumns() == 0);
+
+    delete hss;
     delete h;
+    delete hb;
     delete h2;
     delete h3;
     delete mg;
     delete gr2d;
     delete f;
     delete text;
+    delete latex;
+
+    END_TEST();
+}
+
+void TestRTTSnapshot() {
+    BEGIN_TEST();
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 22, 0)
+    gRTT->SetDirectory("./output/test_rtt");
+    gRTT->SetFileExtension(".txt");
+    ROOT::EnableImplicitMT(4);
+    try {
+        ROOT::RDataFrame df(1000);
+        auto even = df.Define("x", [](ULong64_t e) { return (double)e; }, {"rdfentry_"})
+                        .Define("n", [](ULong64_t e) { return (int)(e % 7); }, {"rdfentry_"})
+                        .Filter([](double x) { return ((int)x) % 2 == 0; }, {"x"});
+        auto ordered = REx::RTTSnapshot<double, int>(even, "rdf_ordered", {"x", "n"}, "", "even entries");
+        auto unordered = REx::RTTSnapshot<double, int>(even, "rdf_unordered", {"x", "n"}, "U");
+        auto binary = REx::RTTSnapshot<double, int>(even, "rdf_binary.bin", {"x", "n"}, "B");
+        SIMPLE_TEST(*ordered == 500 && *unordered == 500 && *binary == 500);
+        SIMPLE_TEST(check_file_content("./output/test_rtt/rdf_ordered.txt", 2, 500, 249500, 1));
+        SIMPLE_TEST(check_file_content("./output/test_rtt/rdf_unordered.txt", 2, 500, 249500, 1));
+
+        // entry order
+        std::ifstream ifs("./output/test_rtt/rdf_ordered.txt");
+        std::string line;
+        double x, prev = -1;
+        bool sorted = true;
+        while (getline(ifs, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            std::stringstream(line) >> x;
+            sorted = sorted && x > prev;
+            prev = x;
+        }
+        SIMPLE_TEST(sorted);
+
+        // 2 doubles per row, no header
+        std::ifstream bin("./output/test_rtt/rdf_binary.bin", std::ios::binary | std::ios::ate);
+        SIMPLE_TEST(bin.is_open() && bin.tellg() == 500 * 2 * (std::streamoff)sizeof(double));
+
+        std::vector<std::string> two_columns{"x", "y"};
+        EXPECTED_EXCEPTION(REx::RTTSnapshotHelper<double>("f", two_columns, 1), std::invalid_argument);
+        EXPECTED_EXCEPTION(REx::RTTSnapshotHelper<double>("f", {"x"}, 0), std::invalid_argument);
+    }
+    catch (const std::exception& e) {
+        EXCEPTION_CAUGHT(e);
+    }
+    ROOT::DisableImplicitMT();
+#endif
+    END_TEST();
+}
+
+void TestRTTMerge() {
+    BEGIN_TEST();
+    gRTT->SetDirectory("./output/test_rtt");
+    gRTT->SetFileExtension(".txt");
+
+    // partial files : h (content = file index + 1 in each bin) and gr (one point per file)
+    const int nfiles = 6;
+    const int N = 5;
+    REx::FileMerger merger;
+    for (int i = 0; i < nfiles; i++) {
+        TString filename = TString::Format("./output/test_rtt/partial_%d.root", i);
+        std::unique_ptr<TFile> file(TFile::Open(filename, "RECREATE"));
+        TH1D h("h", "partial;x;y", N, 0, N);
+        h.SetDirectory(nullptr);
+        for (int k = 1; k <= N; k++)
+            h.SetBinContent(k, i + 1);
+        h.Write();
+        TGraph gr(1);
+        gr.SetName("gr");
+        gr.SetPoint(0, i, 2 * i);
+        gr.Write();
+        file->Close();
+        merger.AddFile(filename);
+    }
+    merger.AddObject("h", "merged_h", "E");
+    merger.AddObject("gr", "merged_gr");
+    merger.SetNumberOfThreads(3);
+    merger.SetMaxOpenFiles(2);
+    SIMPLE_TEST(merger.Run());
+
+    const double sum_bin = nfiles * (nfiles + 1) / 2;
+    SIMPLE_TEST(check_file_content("./output/test_rtt/merged_h.txt", 3, N, N * sum_bin, 2));
+    SIMPLE_TEST(check_file_content("./output/test_rtt/merged_gr.txt", 2, nfiles, nfiles * (nfiles - 1), 2));
+    REx::ColumnData cols;
+    SIMPLE_TEST(merger.GetColumns("h", cols) && cols.GetNumberOfRows() == N && cols.GetData("Y")[0] == sum_bin);
 
+    // missing object
+    merger.AddObject("missing");
+    SIMPLE_TEST(!merger.Merge());
     END_TEST();
 }
 
@@ -3,6 +3,8 @@
 
 void TestRTTConfig();
 void TestRTTOutput();
+void TestRTTSnapshot();
+void TestRTTMerge();
 
 bool check_file_content(const char* filename, int _col, int _lin, double _sum = 0, int _idx_col = -1);
 
@@ -0,0 +1,97 @@
+#include "OutputSink.hh"
+#include "PlotSerializer.hh"
+#include "PyplotExportManager.hh"
+#include "macros.hh"
+
+#include "TCanvas.h"
+#include "TGraph.h"
+#include "TROOT.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <vector>
+
+// initialization
+int nfailed = 0;
+int npassed = 0;
+int ntest = 0;
+bool pass_all_tests = true;
+
+// count the allocations of this program (separate from TREx: the global operator new is replaced)
+static std::atomic<long> gAllocations(0);
+
+void* operator new(std::size_t size) {
+    gAllocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+/// @brief The datasets are moved, not copied, and an export allocates a bounded amount per dataset
+void TestAllocations() {
+    BEGIN_TEST();
+
+    REx::PadProperties::Data d;
+    d.label = "label longer than the small string buffer";
+    d.file.first = "output/memory/allocations/data_file_with_a_long_name.txt";
+    std::vector<REx::PadProperties::Data> datasets;
+    datasets.reserve(1);
+    long n0 = gAllocations;
+    datasets.push_back(std::move(d));
+    SIMPLE_TEST(gAllocations == n0);
+    datasets.push_back(datasets[0]); // new buffer and copy of the new dataset, the first one is moved
+    SIMPLE_TEST(gAllocations - n0 <= 3);
+
+    const int sizes[2] = {50, 200};
+    long nalloc[2];
+    for (int k = 0; k < 2; k++) {
+        const int n = sizes[k];
+        TCanvas* ca = new TCanvas("c_alloc", "c_alloc");
+        std::vector<std::unique_ptr<TGraph>> graphs;
+        for (int i = 0; i < n; i++) {
+            graphs.emplace_back(new TGraph(2));
+            graphs[i]->SetName(TString::Format("ga%d", i));
+            graphs[i]->SetTitle(TString::Format("graph number %d", i));
+            graphs[i]->SetPoint(0, 0, i);
+            graphs[i]->SetPoint(1, 1, i);
+            graphs[i]->Draw(i ? "l" : "al");
+        }
+        REx::MemorySink mem;
+        REx::PyplotExportManager pyplot_alloc;
+        pyplot_alloc.SetOutputSink(&mem);
+        long start = gAllocations;
+        pyplot_alloc.ExportPad(ca, "output/memory/allocations");
+        nalloc[k] = gAllocations - start;
+        SIMPLE_TEST(mem.GetEntries().size() == (size_t)n + 1);
+        delete ca;
+    }
+    LOG_INFO("Allocations for the export of " << sizes[0] << " / " << sizes[1] << " graphs: " << nalloc[0] << " / " << nalloc[1]);
+    // constant number per dataset: x4 (x16 if each dataset copied the list of datasets)
+    SIMPLE_TEST(nalloc[1] < 5 * nalloc[0]);
+
+    END_TEST();
+}
+
+// Allocation counts of ExPad (TAllocations)
+int main(int /*argc*/, char** /*argv*/) {
+    gROOT->SetBatch();
+    try {
+        TestAllocations();
+    }
+    catch (const std::exception& ex) {
+        printf("Error: %s\n", ex.what());
+        return EXIT_FAILURE;
+    }
+    return pass_all_tests ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,7 +1,10 @@
 #include "TROOT.h"
 
+#include "DataScan_test.hh"
 #include "DataType_test.hh"
+#include "Decimation_test.hh"
 #include "ExPad_test.hh"
+#include "Log_test.hh"
 #include "RTT_test.hh"
 
 // initialization
@@ -24,9 +27,14 @@ int main(int /*argc*/, char** /*argv*/) {
     // perform the tests
     // (the tests are placed inside a try-catch block to avoid unhandled exceptions)
     try {
+        TestLogger();
         TestDataType();
+        TestDataScan();
+        TestDecimation();
         TestRTTConfig();
         TestRTTOutput();
+        TestRTTSnapshot();
+        TestRTTMerge();
         TestPlotSerializer();
         TestExportManager();
     }